@@ -1,989 +1,7196 @@
 #include <iostream>
 #include <string>
+#include <new>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <condition_variable>
+#include <random>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <climits>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 using namespace std;
 
+// ==================== ALLOCATION COUNTING ====================
+// Heap allocations made by each thread; read by the benchmark suite to report
+// allocations per operation. A per-thread counter keeps the hook a plain add.
+// The hook replaces the global operator new, so it is only compiled into
+// benchmark builds (-DUNIVERSE_COUNT_ALLOCATIONS); other builds report
+// allocations as null. The deletes stay out of line so GCC doesn't pair
+// inlined free() calls with new-expressions and warn about mismatched
+// allocation functions.
+thread_local long long threadAllocations = 0;
+
+#ifdef UNIVERSE_COUNT_ALLOCATIONS
+#define ALLOCATIONS_COUNTED true
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ALLOC_HOOK __attribute__((noinline))
+#else
+#define ALLOC_HOOK
+#endif
+
+void* operator new(size_t size) {
+    threadAllocations++;
+    void* block = malloc(size ? size : 1);
+    if (!block) throw bad_alloc();
+    return block;
+}
+
+ALLOC_HOOK void operator delete(void* block) noexcept {
+    free(block);
+}
+
+ALLOC_HOOK void operator delete(void* block, size_t) noexcept {
+    free(block);
+}
+#else
+#define ALLOCATIONS_COUNTED false
+#endif
+
 // ==================== BASE LINKED LIST NODE ====================
 template <typename T>
 struct ListNode {
     T data;
     ListNode<T>* next;
 
-    ListNode(T val) : data(val), next(nullptr) {}
+    ListNode(T val) : data(move(val)), next(nullptr) {}
 };
 
-// ==================== HASH TABLE MODULE ====================
-struct User {
-    string userName;
-    string password;
-    string role; // student | teacher | admin
-    string department;
-    string email;
-    string lastBookedRoom;
-    User* next; // for chaining
+// ==================== STRING HASHING ====================
+inline unsigned int hashString(const string& key) {
+    unsigned int hash = 2166136261u;
+    for (char c : key) {
+        hash = (hash ^ (unsigned char)c) * 16777619u;
+    }
+    return hash;
+}
 
-    User(string uname, string pwd, string r, string dept, string mail) : userName(uname), password(pwd), role(r), department(dept),  email(mail), lastBookedRoom(""), next(nullptr) {}
-};
+// ==================== BIT HELPERS ====================
+inline int popCount64(unsigned long long x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    int count = 0;
+    while (x) {
+        x &= x - 1;
+        count++;
+    }
+    return count;
+#endif
+}
 
-class HashTable {
+inline int lowestBit64(unsigned long long x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int index = 0;
+    while (!(x & 1ULL)) {
+        x >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+inline int highestBit64(unsigned long long x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(x);
+#else
+    int index = 0;
+    while (x >>= 1) index++;
+    return index;
+#endif
+}
+
+// ==================== NODE POOL ====================
+// Typed slab allocator behind every linked structure. Nodes are carved out
+// of 64-slot slabs and freed slots are chained through a per-pool free list,
+// so steady-state inserts and deletes never go back to the global heap.
+// When the pool is released, all slabs go at once: live nodes are found by
+// sweeping the slabs in order rather than by walking the owning structure.
+template <typename T>
+class NodePool {
 private:
-    int capacity;
-    int size;
-    User** table;
+    static const int SLAB_SIZE = 64; // one occupancy word per slab during release
 
-    int hashFunction(string key) {
-        int hash = 0;
-        for (char c : key) {
-            hash = (hash * 31 + c) % capacity;
-        }
-        return hash;
-    }
+    struct Slab {
+        Slab* next;
+        alignas(T) unsigned char storage[SLAB_SIZE * sizeof(T)];
 
-    void resizeTable() {
-        int oldCapacity = capacity;
-        capacity *= 2;
-        User** newTable = new User * [capacity]();
+        T* slot(int i) { return reinterpret_cast<T*>(storage + i * sizeof(T)); }
+    };
 
-        for (int i = 0; i < oldCapacity; i++) {
-            User* entry = table[i];
-            while (entry) {
-                User* next = entry->next;
-                int index = hashFunction(entry->userName);
-                entry->next = newTable[index];
-                newTable[index] = entry;
-                entry = next;
-            }
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+    static_assert(sizeof(T) >= sizeof(FreeSlot), "pooled type is too small for a free-list link");
+
+    Slab* slabs;
+    FreeSlot* freeList;
+    int slabCount;
+    int live;
+
+    void addSlab() {
+        Slab* slab = new Slab;
+        slab->next = slabs;
+        slabs = slab;
+        slabCount++;
+        for (int i = SLAB_SIZE - 1; i >= 0; i--) {
+            FreeSlot* slot = reinterpret_cast<FreeSlot*>(slab->slot(i));
+            slot->next = freeList;
+            freeList = slot;
         }
-        delete[] table;
-        table = newTable;
     }
 
-public:
-    HashTable(int initialCapacity = 10) : capacity(initialCapacity), size(0) {
-        table = new User * [capacity]();
+    static int compareSlabs(const void* a, const void* b) {
+        uintptr_t x = reinterpret_cast<uintptr_t>(*(Slab* const*)a);
+        uintptr_t y = reinterpret_cast<uintptr_t>(*(Slab* const*)b);
+        return x < y ? -1 : (x > y ? 1 : 0);
     }
 
-    ~HashTable() {
-        for (int i = 0; i < capacity; i++) {
-            User* entry = table[i];
-            while (entry) {
-                User* temp = entry;
-                entry = entry->next;
-                delete temp;
+    // Runs the destructor of every live node. Free slots are told apart by
+    // looking each free-list entry up in an address-sorted slab table.
+    void destroyLive() {
+        Slab** order = new Slab * [slabCount];
+        int n = 0;
+        for (Slab* slab = slabs; slab; slab = slab->next) order[n++] = slab;
+        qsort(order, slabCount, sizeof(Slab*), compareSlabs);
+
+        unsigned long long* freeBits = new unsigned long long[slabCount]();
+        for (FreeSlot* slot = freeList; slot; slot = slot->next) {
+            uintptr_t address = reinterpret_cast<uintptr_t>(slot);
+            int lo = 0, hi = slabCount - 1;
+            while (lo < hi) {
+                int mid = (lo + hi + 1) / 2;
+                if (reinterpret_cast<uintptr_t>(order[mid]) <= address) lo = mid;
+                else hi = mid - 1;
             }
+            int index = (int)((address - reinterpret_cast<uintptr_t>(order[lo]->storage)) / sizeof(T));
+            freeBits[lo] |= 1ULL << index;
         }
-        delete[] table;
-    }
 
-    bool registerUser(string userName, string password, string role,
-        string department, string email) {
-        if (searchUser(userName)) {
-            cout << "User already exists!" << endl;
-            return false;
+        for (int i = 0; i < slabCount; i++) {
+            unsigned long long liveBits = ~freeBits[i];
+            while (liveBits) {
+                order[i]->slot(lowestBit64(liveBits))->~T();
+                liveBits &= liveBits - 1;
+            }
         }
+        delete[] freeBits;
+        delete[] order;
+    }
 
-        if ((float)size / capacity > 0.7) {
-            resizeTable();
-        }
+public:
+    NodePool() : slabs(nullptr), freeList(nullptr), slabCount(0), live(0) {}
 
-        int index = hashFunction(userName);
-        User* newUser = new User(userName, password, role, department, email);
-        newUser->next = table[index];
-        table[index] = newUser;
-        size++;
-        return true;
+    ~NodePool() {
+        releaseAll();
     }
 
-    User* login(string userName, string password) {
-        int index = hashFunction(userName);
-        User* user = table[index];
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
 
-        while (user) {
-            if (user->userName == userName && user->password == password) {
-                return user;
-            }
-            user = user->next;
-        }
-        return nullptr;
+    template <typename... Args>
+    T* create(Args&&... args) {
+        if (!freeList) addSlab();
+        FreeSlot* slot = freeList;
+        freeList = slot->next;
+        live++;
+        return new (slot) T(forward<Args>(args)...);
     }
 
-    User* searchUser(string userName) {
-        int index = hashFunction(userName);
-        User* user = table[index];
-
-        while (user) {
-            if (user->userName == userName) {
-                return user;
-            }
-            user = user->next;
-        }
-        return nullptr;
+    void destroy(T* node) {
+        node->~T();
+        FreeSlot* slot = reinterpret_cast<FreeSlot*>(node);
+        slot->next = freeList;
+        freeList = slot;
+        live--;
     }
 
-    bool updateUser(string userName, string newPassword,
-        string newDepartment, string newEmail) {
-        User* user = searchUser(userName);
-        if (user) {
-            if (!newPassword.empty()) 
-                user->password = newPassword;
-            if (!newDepartment.empty()) 
-                user->department = newDepartment;
-            if (!newEmail.empty()) 
-                user->email = newEmail;
-            return true;
+    // Destroys every node still allocated and hands all slabs back to the heap
+    void releaseAll() {
+        if (live > 0 && !is_trivially_destructible<T>::value) {
+            destroyLive();
         }
-        return false;
+        while (slabs) {
+            Slab* temp = slabs;
+            slabs = slabs->next;
+            delete temp;
+        }
+        freeList = nullptr;
+        slabCount = 0;
+        live = 0;
     }
 
-    bool deleteUser(string userName) {
-        int index = hashFunction(userName);
-        User* user = table[index];
-        User* prev = nullptr;
+    int liveCount() { return live; }
+    int getSlabCount() { return slabCount; }
+};
 
-        while (user) {
-            if (user->userName == userName) {
-                if (prev) {
-                    prev->next = user->next;
-                }
-                else {
-                    table[index] = user->next;
-                }
-                delete user;
-                size--;
-                return true;
-            }
-            prev = user;
-            user = user->next;
-        }
-        return false;
-    }
+// ==================== LINKED CONTAINERS ====================
+// One list template behind the queues, stacks and adjacency lists. Policies
+// are picked at compile time:
+//   Storage   - Owning<T> keeps each value in a ListNode<T> the list allocates;
+//               Intrusive<T> links T objects through their own next member (and
+//               prev, when T has one, for O(1) unlink) and never allocates
+//   Allocator - where owning nodes come from: HeapAllocator or PoolAllocator
+//   Inline    - owning lists serve their first Inline nodes from a buffer
+//               inside the list, so short-lived small lists never allocate
+template <typename Node>
+struct HeapAllocator {
+    static const bool RELEASES_ALL = false; // nodes must be freed one by one
+
+    template <typename... Args>
+    Node* create(Args&&... args) { return new Node(forward<Args>(args)...); }
+    void destroy(Node* node) { delete node; }
+};
 
-    void displayAllUsers() {
-        for (int i = 0; i < capacity; i++) {
-            cout << "Bucket " << i << ": ";
-            User* user = table[i];
-            if (!user) {
-                cout << "Empty" << endl;
-                continue;
-            }
-            while (user) {
-                cout << user->userName << "(" << user->role << ")";
-                if (user->next) cout << " -> ";
-                user = user->next;
-            }
-            cout << endl;
-        }
+template <typename Node>
+struct PoolAllocator {
+    static const bool RELEASES_ALL = true; // the pool frees every slab at once
+
+    NodePool<Node> pool;
+
+    template <typename... Args>
+    Node* create(Args&&... args) { return pool.create(forward<Args>(args)...); }
+    void destroy(Node* node) { pool.destroy(node); }
+};
+
+template <typename T>
+struct Owning {
+    typedef ListNode<T> Node;
+    static const bool OWNS_NODES = true;
+};
+
+template <typename T>
+struct Intrusive {
+    typedef T Node;
+    static const bool OWNS_NODES = false;
+};
+
+template <typename Node, typename = void>
+struct HasPrevLink : false_type {};
+
+template <typename Node>
+struct HasPrevLink<Node, decltype((void)declval<Node&>().prev)> : true_type {};
+
+// Allocator plus an optional inline buffer; free inline slots are bits in one word
+template <typename Node, template <typename> class Allocator, int Inline>
+class NodeSource {
+private:
+    static_assert(Inline > 0 && Inline <= 64, "inline capacity is tracked in one 64-bit mask");
+
+    Allocator<Node> allocator;
+    alignas(Node) unsigned char buffer[Inline * sizeof(Node)];
+    unsigned long long freeSlots;
+
+public:
+    static const bool RELEASES_ALL = Allocator<Node>::RELEASES_ALL && is_trivially_destructible<Node>::value;
+
+    NodeSource() : freeSlots(Inline == 64 ? ~0ULL : (1ULL << Inline) - 1) {}
+
+    template <typename... Args>
+    Node* create(Args&&... args) {
+        if (!freeSlots) return allocator.create(forward<Args>(args)...);
+        int slot = lowestBit64(freeSlots);
+        freeSlots &= freeSlots - 1;
+        return new (buffer + slot * sizeof(Node)) Node(forward<Args>(args)...);
     }
 
-    void updateLastBookedRoom(string userName, string roomID) {
-        User* user = searchUser(userName);
-        if (user) {
-            user->lastBookedRoom = roomID;
+    void destroy(Node* node) {
+        unsigned char* address = reinterpret_cast<unsigned char*>(node);
+        if (address < buffer || address >= buffer + sizeof(buffer)) {
+            allocator.destroy(node);
+            return;
         }
+        node->~Node();
+        freeSlots |= 1ULL << ((address - buffer) / sizeof(Node));
     }
 };
 
-// ==================== GRAPH/CAMPUS MAP MODULE ====================
-struct Edge {
-    string destBuilding;
-    int distance;
-    string pathType;
-    Edge* next;
+template <typename Node, template <typename> class Allocator>
+class NodeSource<Node, Allocator, 0> : public Allocator<Node> {};
 
-    Edge(string dest, int dist, string type = "road") : destBuilding(dest), distance(dist), pathType(type), next(nullptr) {}
+struct NoNodeSource {};
+
+// Queues need the tail and a count; a singly linked intrusive list is used
+// as a stack (adjacency lists, free lists) and is just a head pointer, so it
+// stays as small as the raw pointer it replaces
+template <typename Node, bool TrackEnds>
+struct ListEnds {
+    Node* head;
+    Node* tail;
+    int count;
+
+    ListEnds() : head(nullptr), tail(nullptr), count(0) {}
 };
 
-struct Building {
-    string name;
-    Edge* edges;
-    Building* next;
+template <typename Node>
+struct ListEnds<Node, false> {
+    Node* head;
 
-    Building(string n) : name(n), edges(nullptr), next(nullptr) {}
+    ListEnds() : head(nullptr) {}
 };
 
-class CampusGraph {
+template <typename T, template <typename> class Storage = Owning,
+    template <typename> class Allocator = PoolAllocator, int Inline = 0>
+class LinkedList {
+public:
+    typedef typename Storage<T>::Node Node;
+
 private:
-    Building* buildings;
-    int buildingCount;
+    static const bool OWNS_NODES = Storage<T>::OWNS_NODES;
+    static const bool DOUBLY_LINKED = HasPrevLink<Node>::value;
+    static const bool TRACK_ENDS = OWNS_NODES || DOUBLY_LINKED;
+
+    ListEnds<Node, TRACK_ENDS> ends;
+    typename conditional<OWNS_NODES, NodeSource<Node, Allocator, Inline>, NoNodeSource>::type source;
+
+    void attachFront(Node* node) {
+        node->next = ends.head;
+        if constexpr (DOUBLY_LINKED) {
+            node->prev = nullptr;
+            if (ends.head) ends.head->prev = node;
+        }
+        if constexpr (TRACK_ENDS) {
+            if (!ends.tail) ends.tail = node;
+            ends.count++;
+        }
+        ends.head = node;
+    }
 
-    Building* findBuilding(string name) {
-        Building* current = buildings;
-        while (current) {
-            if (current->name == name)
-                return current;
-            current = current->next;
+    void attachBack(Node* node) {
+        static_assert(TRACK_ENDS, "a head-only list has no back; use linkFront");
+        node->next = nullptr;
+        if constexpr (DOUBLY_LINKED) node->prev = ends.tail;
+        if (ends.tail) ends.tail->next = node;
+        else ends.head = node;
+        ends.tail = node;
+        ends.count++;
+    }
+
+    // prev is the node before `node`, or nullptr when node is the head
+    void detach(Node* prev, Node* node) {
+        if (prev) prev->next = node->next;
+        else ends.head = node->next;
+        if constexpr (DOUBLY_LINKED) {
+            if (node->next) node->next->prev = prev;
+            node->prev = nullptr;
         }
-        return nullptr;
+        if constexpr (TRACK_ENDS) {
+            if (ends.tail == node) ends.tail = prev;
+            ends.count--;
+        }
+        node->next = nullptr;
+    }
+
+    Node* detachFront() {
+        Node* node = ends.head;
+        detach(nullptr, node);
+        return node;
     }
 
 public:
-    CampusGraph() : buildings(nullptr), buildingCount(0) {}
+    LinkedList() {}
 
-    ~CampusGraph() {
-        Building* current = buildings;
-        while (current) {
-            Edge* edge = current->edges;
-            while (edge) {
-                Edge* temp = edge;
-                edge = edge->next;
-                delete temp;
-            }
-            Building* temp = current;
-            current = current->next;
-            delete temp;
+    ~LinkedList() {
+        if constexpr (OWNS_NODES) {
+            if (!decltype(source)::RELEASES_ALL) clear();
         }
     }
 
-    bool addBuilding(string name) {
-        if (findBuilding(name)) {
-            cout << "Building already exists!" << endl;
-            return false;
-        }
+    // Owning lists hand out pointers into their inline buffer
+    LinkedList(const LinkedList&) = delete;
+    LinkedList& operator=(const LinkedList&) = delete;
+
+    // ---- owning storage: the list creates and destroys nodes ----
+    template <typename... Args>
+    T& emplaceFront(Args&&... args) {
+        static_assert(OWNS_NODES, "emplace needs owning storage");
+        Node* node = source.create(T(forward<Args>(args)...));
+        attachFront(node);
+        return node->data;
+    }
 
-        Building* newBuilding = new Building(name);
-        newBuilding->next = buildings;
-        buildings = newBuilding;
-        buildingCount++;
-        return true;
+    template <typename... Args>
+    T& emplaceBack(Args&&... args) {
+        static_assert(OWNS_NODES, "emplace needs owning storage");
+        Node* node = source.create(T(forward<Args>(args)...));
+        attachBack(node);
+        return node->data;
     }
 
-    bool removeBuilding(string name) {
-        Building* current = buildings;
-        Building* prev = nullptr;
+    void pushFront(T value) { emplaceFront(move(value)); }
+    void pushBack(T value) { emplaceBack(move(value)); }
 
-        while (current) {
-            if (current->name == name) {
-                // Remove building from adjacency lists
-                Building* temp = buildings;
-                while (temp) {
-                    removePath(temp->name, name);
-                    temp = temp->next;
-                }
+    T popFront() {
+        static_assert(OWNS_NODES, "popFront needs owning storage; use unlinkFront");
+        if (!ends.head) throw "List is empty!";
+        Node* node = detachFront();
+        T value = move(node->data);
+        source.destroy(node);
+        return value;
+    }
 
-                // Remove building's edges
-                Edge* edge = current->edges;
-                while (edge) {
-                    Edge* tempEdge = edge;
-                    edge = edge->next;
-                    delete tempEdge;
-                }
+    T& front() {
+        static_assert(OWNS_NODES, "front needs owning storage; use first");
+        if (!ends.head) throw "List is empty!";
+        return ends.head->data;
+    }
 
-                // Remove building node
-                if (prev) {
-                    prev->next = current->next;
-                }
-                else {
-                    buildings = current->next;
-                }
-                delete current;
-                buildingCount--;
-                return true;
-            }
-            prev = current;
-            current = current->next;
+    // ---- intrusive storage: the caller owns the nodes ----
+    void linkFront(Node* node) {
+        static_assert(!OWNS_NODES, "link needs intrusive storage");
+        attachFront(node);
+    }
+
+    void linkBack(Node* node) {
+        static_assert(!OWNS_NODES, "link needs intrusive storage");
+        attachBack(node);
+    }
+
+    Node* unlinkFront() {
+        static_assert(!OWNS_NODES, "unlink needs intrusive storage");
+        return ends.head ? detachFront() : nullptr;
+    }
+
+    // O(1) when nodes carry a prev link, otherwise walks to the predecessor
+    void unlink(Node* node) {
+        static_assert(!OWNS_NODES, "unlink needs intrusive storage");
+        Node* prev = nullptr;
+        if constexpr (DOUBLY_LINKED) {
+            prev = node->prev;
         }
-        return false;
+        else {
+            for (Node* current = ends.head; current != node; current = current->next) prev = current;
+        }
+        detach(prev, node);
     }
 
-    bool addPath(string src, string dest, int distance = 1) {
-        Building* srcBuilding = findBuilding(src);
-        Building* destBuilding = findBuilding(dest);
+    // Unlinks and returns the first node matching pred, or nullptr
+    template <typename Predicate>
+    Node* unlinkFirst(Predicate pred) {
+        static_assert(!OWNS_NODES, "unlink needs intrusive storage");
+        Node* prev = nullptr;
+        for (Node* current = ends.head; current; prev = current, current = current->next) {
+            if (pred(*current)) {
+                detach(prev, current);
+                return current;
+            }
+        }
+        return nullptr;
+    }
 
-        if (!srcBuilding || !destBuilding) {
-            cout << "One or both buildings not found!" << endl;
-            return false;
+    // ---- both ----
+    // Drops every node; owning lists destroy them, intrusive lists just forget them
+    void clear() {
+        if constexpr (OWNS_NODES) {
+            while (ends.head) source.destroy(detachFront());
         }
+        ends = ListEnds<Node, TRACK_ENDS>();
+    }
 
-        // Add edge from src to dest
-        Edge* newEdge1 = new Edge(dest, distance);
-        newEdge1->next = srcBuilding->edges;
-        srcBuilding->edges = newEdge1;
+    // Walk with node->next
+    Node* first() { return ends.head; }
 
-        // Add edge from dest to src (undirected)
-        Edge* newEdge2 = new Edge(src, distance);
-        newEdge2->next = destBuilding->edges;
-        destBuilding->edges = newEdge2;
+    Node* last() {
+        static_assert(TRACK_ENDS, "a head-only list does not track its last node");
+        return ends.tail;
+    }
 
-        return true;
+    bool isEmpty() { return ends.head == nullptr; }
+
+    // O(n) on a head-only list
+    int getSize() {
+        if constexpr (TRACK_ENDS) {
+            return ends.count;
+        }
+        else {
+            int count = 0;
+            for (Node* node = ends.head; node; node = node->next) count++;
+            return count;
+        }
     }
+};
 
-    bool removePath(string src, string dest) {
-        Building* srcBuilding = findBuilding(src);
-        Building* destBuilding = findBuilding(dest);
+template <typename T, template <typename> class Allocator = PoolAllocator, int Inline = 0>
+using LinkedQueue = LinkedList<T, Owning, Allocator, Inline>; // pushBack / popFront
 
-        if (!srcBuilding || !destBuilding) return false;
+template <typename T, template <typename> class Allocator = PoolAllocator, int Inline = 0>
+using LinkedStack = LinkedList<T, Owning, Allocator, Inline>; // pushFront / popFront
 
-        // Remove edge from src to dest
-        Edge* edge = srcBuilding->edges;
-        Edge* prev = nullptr;
-        while (edge) {
-            if (edge->destBuilding == dest) {
-                if (prev) {
-                    prev->next = edge->next;
-                }
-                else {
-                    srcBuilding->edges = edge->next;
-                }
-                delete edge;
-                break;
-            }
-            prev = edge;
-            edge = edge->next;
+template <typename T>
+using IntrusiveList = LinkedList<T, Intrusive>;
+
+// ==================== STRING INTERNING ====================
+// Roles, departments, room and path types, building names in edges and
+// complaints, and message senders/recipients repeat across many records.
+// Each distinct value is stored once in a global pool and records hold an
+// 8-byte handle, so comparing two values is a pointer compare. Entries are
+// never removed, which keeps every handle valid for the life of the process.
+// Heap bytes a string owns beyond the object itself (0 while it fits the inline buffer)
+inline size_t stringHeapBytes(const string& str) {
+    const char* data = str.data();
+    const char* self = reinterpret_cast<const char*>(&str);
+    if (data >= self && data < self + sizeof(string)) return 0;
+    return str.capacity() + 1;
+}
+
+struct InternEntry {
+    string text;
+    unsigned int hash;
+    InternEntry* next; // for chaining
+
+    InternEntry(const string& t, unsigned int h) : text(t), hash(h), next(nullptr) {}
+};
+
+class StringPool {
+private:
+    InternEntry** table;
+    int capacity; // power of two
+    int count;
+    size_t textBytes;
+    NodePool<InternEntry> entries;
+    mutex lock;
+
+    InternEntry* findLocked(const string& text, unsigned int hash) {
+        InternEntry* entry = table[hash & (capacity - 1)];
+        while (entry && (entry->hash != hash || entry->text != text)) {
+            entry = entry->next;
         }
+        return entry;
+    }
 
-        // Remove edge from dest to src
-        edge = destBuilding->edges;
-        prev = nullptr;
-        while (edge) {
-            if (edge->destBuilding == src) {
-                if (prev) {
-                    prev->next = edge->next;
-                }
-                else {
-                    destBuilding->edges = edge->next;
-                }
-                delete edge;
-                break;
+    void growTable() {
+        int oldCapacity = capacity;
+        capacity *= 2;
+        InternEntry** newTable = new InternEntry * [capacity]();
+        for (int i = 0; i < oldCapacity; i++) {
+            InternEntry* entry = table[i];
+            while (entry) {
+                InternEntry* next = entry->next;
+                entry->next = newTable[entry->hash & (capacity - 1)];
+                newTable[entry->hash & (capacity - 1)] = entry;
+                entry = next;
             }
-            prev = edge;
-            edge = edge->next;
         }
+        delete[] table;
+        table = newTable;
+    }
 
-        return true;
+    StringPool() : capacity(256), count(0), textBytes(0) {
+        table = new InternEntry * [capacity]();
     }
 
-    void BFS(string start) {
-        Building* startBuilding = findBuilding(start);
-        if (!startBuilding) {
-            cout << "Building not found!" << endl;
-            return;
+    ~StringPool() {
+        delete[] table;
+    }
+
+public:
+    static StringPool& global() {
+        static StringPool pool;
+        return pool;
+    }
+
+    const InternEntry* intern(const string& text) {
+        unsigned int hash = hashString(text);
+        lock_guard<mutex> guard(lock);
+        InternEntry* entry = findLocked(text, hash);
+        if (entry) return entry;
+
+        if (count > capacity - capacity / 4) {
+            growTable();
         }
+        entry = entries.create(text, hash);
+        entry->next = table[hash & (capacity - 1)];
+        table[hash & (capacity - 1)] = entry;
+        count++;
+        textBytes += stringHeapBytes(entry->text);
+        return entry;
+    }
 
-        // Custom queue using array
-        Building* queue[100];
-        bool visited[100] = { false };
-        int front = 0, rear = 0;
+    // nullptr when the text was never interned; never adds an entry
+    const InternEntry* find(const string& text) {
+        unsigned int hash = hashString(text);
+        lock_guard<mutex> guard(lock);
+        return findLocked(text, hash);
+    }
 
-        queue[rear++] = startBuilding;
-        visited[getIndex(start)] = true;
+    int getCount() { return count; }
 
-        cout << "BFS from " << start << ": ";
+    size_t memoryBytes() {
+        return capacity * sizeof(InternEntry*) + count * sizeof(InternEntry) + textBytes;
+    }
+};
 
-        while (front < rear) {
-            Building* current = queue[front++];
-            cout << current->name << " ";
+class InternedString {
+private:
+    const InternEntry* entry;
 
-            Edge* edge = current->edges;
-            while (edge) {
-                Building* adj = findBuilding(edge->destBuilding);
-                int idx = getIndex(adj->name);
-                if (!visited[idx]) {
-                    queue[rear++] = adj;
-                    visited[idx] = true;
-                }
-                edge = edge->next;
-            }
+    static const InternEntry* emptyEntry() {
+        static const InternEntry* empty = StringPool::global().intern("");
+        return empty;
+    }
+
+public:
+    InternedString() : entry(emptyEntry()) {}
+    InternedString(const string& text) : entry(StringPool::global().intern(text)) {}
+    InternedString(const char* text) : entry(StringPool::global().intern(text)) {}
+
+    // Looks up an existing value without growing the pool, for queries whose
+    // argument may match nothing; returns false when it was never interned
+    static bool find(const string& text, InternedString& out) {
+        const InternEntry* found = StringPool::global().find(text);
+        if (found) out.entry = found;
+        return found != nullptr;
+    }
+
+    const string& str() const { return entry->text; }
+    operator const string&() const { return entry->text; }
+    bool empty() const { return entry->text.empty(); }
+
+    bool operator==(const InternedString& other) const { return entry == other.entry; }
+    bool operator!=(const InternedString& other) const { return entry != other.entry; }
+};
+
+inline ostream& operator<<(ostream& out, const InternedString& value) {
+    return out << value.str();
+}
+
+// ==================== CLOCK MODULE ====================
+// Complaints and messages are stamped with milliseconds since the Unix epoch
+// as plain 64-bit integers, so they compare, bucket and binary-search without
+// parsing. The wall clock is read once at startup and advanced with the
+// steady clock after that, so stamps never run backwards when the system time
+// is adjusted. Each script command ticks the clock once and every record it
+// creates shares that cached reading; menu actions tick when they store.
+inline long long steadyNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const long long MILLIS_PER_SECOND = 1000;
+const long long MILLIS_PER_DAY = 24LL * 60 * 60 * MILLIS_PER_SECOND;
+
+class CampusClock {
+private:
+    long long epochOffset; // wall clock minus steady clock, nanoseconds
+    atomic<long long> cached; // epoch milliseconds
+
+public:
+    CampusClock() : epochOffset(0), cached(0) {
+        long long wall = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        epochOffset = wall - steadyNanos();
+        tick();
+    }
+
+    // Refreshes the cached reading and returns it
+    long long tick() {
+        long long now = (steadyNanos() + epochOffset) / 1000000;
+        long long seen = cached.load(memory_order_relaxed);
+        while (now > seen && !cached.compare_exchange_weak(seen, now, memory_order_relaxed)) {}
+        return now > seen ? now : seen;
+    }
+
+    long long now() const { return cached.load(memory_order_relaxed); }
+};
+
+CampusClock campusClock;
+
+inline bool localParts(long long millis, tm& parts) {
+    time_t seconds = (time_t)(millis / MILLIS_PER_SECOND);
+#ifdef _WIN32
+    return localtime_s(&parts, &seconds) == 0;
+#else
+    return localtime_r(&seconds, &parts) != nullptr;
+#endif
+}
+
+// "YYYY-MM-DD HH:MM:SS" in local time. Listings print runs of records from the
+// same second, so the last conversion is kept per thread.
+inline const char* formatTimestamp(long long millis) {
+    thread_local long long cachedSecond = LLONG_MIN;
+    thread_local char text[32];
+    long long second = millis / MILLIS_PER_SECOND;
+    if (second != cachedSecond) {
+        tm parts;
+        if (!localParts(millis, parts) || strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &parts) == 0) {
+            snprintf(text, sizeof(text), "%lld", millis);
         }
-        cout << endl;
+        cachedSecond = second;
     }
+    return text;
+}
 
-    void DFS(string start) {
-        Building* startBuilding = findBuilding(start);
-        if (!startBuilding) {
-            cout << "Building not found!" << endl;
-            return;
+// Local midnight of the day holding millis
+inline long long startOfDay(long long millis) {
+    tm parts;
+    if (!localParts(millis, parts)) return millis - millis % MILLIS_PER_DAY;
+    parts.tm_hour = parts.tm_min = parts.tm_sec = 0;
+    parts.tm_isdst = -1;
+    return (long long)mktime(&parts) * MILLIS_PER_SECOND;
+}
+
+// Reads a point in time for range queries, relative to now:
+//   30m, 2h, 1d, 1w          - that long ago
+//   today, monday .. sunday  - local midnight of today or the latest such day (mon .. sun also work)
+//   2026-03-02[ 14:30]       - local date and optional time
+bool parseTimeArg(const string& text, long long now, long long& millis) {
+    if (text.empty()) return false;
+
+    size_t digits = 0;
+    while (digits < text.size() && text[digits] >= '0' && text[digits] <= '9') digits++;
+    if (digits > 0 && digits <= 9 && digits + 1 == text.size()) {
+        long long amount = atoll(text.c_str());
+        long long unit = 0;
+        switch (text[digits]) {
+        case 'm': unit = 60 * MILLIS_PER_SECOND; break;
+        case 'h': unit = 60 * 60 * MILLIS_PER_SECOND; break;
+        case 'd': unit = MILLIS_PER_DAY; break;
+        case 'w': unit = 7 * MILLIS_PER_DAY; break;
+        default: return false;
+        }
+        millis = now - amount * unit;
+        return true;
+    }
+
+    if (text == "today") {
+        millis = startOfDay(now);
+        return true;
+    }
+    static const char* const DAY_NAMES[7] = { "sunday", "monday", "tuesday", "wednesday", "thursday", "friday", "saturday" };
+    for (int day = 0; day < 7; day++) {
+        if (text == DAY_NAMES[day] || text == string(DAY_NAMES[day], 3)) {
+            tm parts;
+            if (!localParts(now, parts)) return false;
+            int back = (parts.tm_wday - day + 7) % 7;
+            // Step back by calendar days rather than fixed 24 hours so DST changes don't shift the result
+            parts.tm_mday -= back;
+            parts.tm_hour = parts.tm_min = parts.tm_sec = 0;
+            parts.tm_isdst = -1;
+            millis = (long long)mktime(&parts) * MILLIS_PER_SECOND;
+            return true;
         }
+    }
 
-        // Custom stack using array
-        Building* stack[100];
-        bool visited[100] = { false };
-        int top = 0;
+    int year, month, day, hour = 0, minute = 0;
+    char extra;
+    int fields = sscanf(text.c_str(), "%4d-%2d-%2d %2d:%2d%c", &year, &month, &day, &hour, &minute, &extra);
+    if (fields != 5 && (fields != 3 || text.size() != 10)) return false;
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour < 0 || hour > 23 || minute < 0 || minute > 59) return false;
+    tm parts = {};
+    parts.tm_year = year - 1900;
+    parts.tm_mon = month - 1;
+    parts.tm_mday = day;
+    parts.tm_hour = hour;
+    parts.tm_min = minute;
+    parts.tm_isdst = -1;
+    time_t seconds = mktime(&parts);
+    if (seconds == (time_t)-1) return false;
+    millis = (long long)seconds * MILLIS_PER_SECOND;
+    return true;
+}
 
-        stack[top++] = startBuilding;
-        cout << "DFS from " << start << ": ";
+// ==================== METRICS MODULE ====================
+// Counters and latency histograms for the hot paths. Each thread writes only
+// its own block (relaxed load + store, i.e. a plain add), and readers merge
+// every registered block. Build with -DUNIVERSE_NO_METRICS to compile the
+// recording macros out entirely.
+
+enum MetricOp {
+    OP_REGISTER, OP_LOGIN, OP_USER_SEARCH,
+    OP_PATH_ADD, OP_PATH_REMOVE, OP_TRAVERSAL,
+    OP_ROOM_SEARCH, OP_ROOM_RESERVE, OP_SLOT_BOOKING, OP_FREE_ROOM_SEARCH,
+    OP_COMPLAINT_SUBMIT, OP_COMPLAINT_PROCESS, OP_COMPLAINT_WAIT,
+    OP_MESSAGE_SEND, OP_INBOX_READ,
+    OP_SERVER_REQUEST,
+    METRIC_OP_TOTAL
+};
+
+const char* const METRIC_OP_NAMES[METRIC_OP_TOTAL] = {
+    "register", "login", "user_search",
+    "path_add", "path_remove", "traversal",
+    "room_search", "room_reserve", "slot_booking", "free_room_search",
+    "complaint_submit", "complaint_process", "complaint_wait",
+    "message_send", "inbox_read",
+    "server_request"
+};
 
-        while (top > 0) {
-            Building* current = stack[--top];
+enum MetricCounter {
+    CTR_REGISTRATIONS, CTR_LOGINS, CTR_FAILED_LOGINS,
+    CTR_RESERVATIONS, CTR_FAILED_RESERVATIONS, CTR_SLOT_BOOKINGS, CTR_FAILED_SLOT_BOOKINGS,
+    CTR_COMPLAINTS_SUBMITTED, CTR_COMPLAINTS_MERGED, CTR_COMPLAINTS_PROCESSED,
+    CTR_MESSAGES_SENT, CTR_BROADCASTS,
+    METRIC_COUNTER_TOTAL
+};
 
-            if (!visited[getIndex(current->name)]) {
-                cout << current->name << " ";
-                visited[getIndex(current->name)] = true;
+const char* const METRIC_COUNTER_NAMES[METRIC_COUNTER_TOTAL] = {
+    "registrations", "logins", "failed_logins",
+    "reservations", "failed_reservations", "slot_bookings", "failed_slot_bookings",
+    "complaints_submitted", "complaints_merged", "complaints_processed",
+    "messages_sent", "broadcasts"
+};
+
+// HDR-style log-linear buckets: values below 8 ns get a bucket each, then
+// every power of two is split into 8 sub-buckets (about 12% resolution) up
+// to 2^40 ns. Larger values land in the last bucket.
+const int LATENCY_SUB_BITS = 3;
+const int LATENCY_SUB_BUCKETS = 1 << LATENCY_SUB_BITS;
+const int LATENCY_MAX_OCTAVE = 40;
+const int LATENCY_SLOTS = (LATENCY_MAX_OCTAVE - LATENCY_SUB_BITS + 2) * LATENCY_SUB_BUCKETS;
+
+inline int latencySlot(long long nanos) {
+    if (nanos < LATENCY_SUB_BUCKETS) return nanos < 0 ? 0 : (int)nanos;
+    int octave = highestBit64((unsigned long long)nanos);
+    int sub = (int)(nanos >> (octave - LATENCY_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+    int slot = (octave - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS + sub;
+    return slot < LATENCY_SLOTS ? slot : LATENCY_SLOTS - 1;
+}
+
+// Smallest value that lands in the slot after this one
+inline long long latencySlotEnd(int slot) {
+    if (slot < LATENCY_SUB_BUCKETS) return slot + 1;
+    int shift = slot / LATENCY_SUB_BUCKETS - 1;
+    return (long long)(LATENCY_SUB_BUCKETS + slot % LATENCY_SUB_BUCKETS + 1) << shift;
+}
+
+struct MetricsBlock {
+    atomic<long long> counters[METRIC_COUNTER_TOTAL];
+    atomic<long long> latency[METRIC_OP_TOTAL][LATENCY_SLOTS];
+    atomic<long long> latencySum[METRIC_OP_TOTAL];
+    MetricsBlock* next;
+};
+
+inline void bump(atomic<long long>& cell, long long by) {
+    cell.store(cell.load(memory_order_relaxed) + by, memory_order_relaxed);
+}
+
+class Metrics {
+private:
+    // Blocks are never freed, so counts from finished threads are kept
+    static atomic<MetricsBlock*> blocks;
+
+    static MetricsBlock* registerBlock() {
+        MetricsBlock* block = new MetricsBlock();
+        MetricsBlock* head = blocks.load(memory_order_relaxed);
+        do {
+            block->next = head;
+        } while (!blocks.compare_exchange_weak(head, block, memory_order_release, memory_order_relaxed));
+        return block;
+    }
+
+    static MetricsBlock& local() {
+        thread_local MetricsBlock* block = registerBlock();
+        return *block;
+    }
+
+public:
+    static void count(MetricCounter counter) {
+        bump(local().counters[counter], 1);
+    }
+
+    static void record(MetricOp op, long long nanos) {
+        MetricsBlock& block = local();
+        bump(block.latency[op][latencySlot(nanos)], 1);
+        bump(block.latencySum[op], nanos);
+    }
+
+    static long long counterTotal(MetricCounter counter) {
+        long long total = 0;
+        for (MetricsBlock* b = blocks.load(memory_order_acquire); b; b = b->next) {
+            total += b->counters[counter].load(memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // Merges every thread's histogram for op; returns the sample count
+    static long long mergeLatency(MetricOp op, long long* slots, long long& sum) {
+        long long total = 0;
+        sum = 0;
+        for (int s = 0; s < LATENCY_SLOTS; s++) slots[s] = 0;
+        for (MetricsBlock* b = blocks.load(memory_order_acquire); b; b = b->next) {
+            for (int s = 0; s < LATENCY_SLOTS; s++) {
+                long long n = b->latency[op][s].load(memory_order_relaxed);
+                slots[s] += n;
+                total += n;
             }
+            sum += b->latencySum[op].load(memory_order_relaxed);
+        }
+        return total;
+    }
 
-            Edge* edge = current->edges;
-            while (edge) {
-                Building* adj = findBuilding(edge->destBuilding);
-                int idx = getIndex(adj->name);
-                if (!visited[idx]) {
-                    stack[top++] = adj;
-                }
-                edge = edge->next;
+    // Upper bound of the bucket holding the given fraction of samples
+    static long long percentile(const long long* slots, long long total, double fraction) {
+        long long target = (long long)(total * fraction);
+        long long seen = 0;
+        for (int s = 0; s < LATENCY_SLOTS; s++) {
+            seen += slots[s];
+            if (seen > target) return latencySlotEnd(s);
+        }
+        return 0;
+    }
+
+    static void reset() {
+        for (MetricsBlock* b = blocks.load(memory_order_acquire); b; b = b->next) {
+            for (int c = 0; c < METRIC_COUNTER_TOTAL; c++) b->counters[c].store(0, memory_order_relaxed);
+            for (int op = 0; op < METRIC_OP_TOTAL; op++) {
+                for (int s = 0; s < LATENCY_SLOTS; s++) b->latency[op][s].store(0, memory_order_relaxed);
+                b->latencySum[op].store(0, memory_order_relaxed);
             }
         }
-        cout << endl;
     }
 
-    void displayAdjacencyList() {
-        Building* current = buildings;
-        while (current) {
-            cout << current->name << " -> ";
-            Edge* edge = current->edges;
-            while (edge) {
-                cout << edge->destBuilding << "(" << edge->distance << ")";
-                if (edge->next) cout << " -> ";
-                edge = edge->next;
+    static void display() {
+        cout << "--- Counters ---" << endl;
+        for (int c = 0; c < METRIC_COUNTER_TOTAL; c++) {
+            cout << METRIC_COUNTER_NAMES[c] << ": " << counterTotal((MetricCounter)c) << endl;
+        }
+        cout << "--- Latency (us) ---" << endl;
+        cout << "op\tcount\tmean\tp50\tp99\tp99.9\tmax" << endl;
+        long long* slots = new long long[LATENCY_SLOTS];
+        for (int op = 0; op < METRIC_OP_TOTAL; op++) {
+            long long sum;
+            long long total = mergeLatency((MetricOp)op, slots, sum);
+            if (total == 0) continue;
+            int highest = LATENCY_SLOTS - 1;
+            while (slots[highest] == 0) highest--;
+            char line[160];
+            snprintf(line, sizeof(line), "%s\t%lld\t%.1f\t%.1f\t%.1f\t%.1f\t%.1f", METRIC_OP_NAMES[op], total,
+                sum / 1e3 / total, percentile(slots, total, 0.50) / 1e3, percentile(slots, total, 0.99) / 1e3,
+                percentile(slots, total, 0.999) / 1e3, latencySlotEnd(highest) / 1e3);
+            cout << line << endl;
+        }
+        delete[] slots;
+    }
+
+    // Prometheus text exposition. Histogram buckets are cumulative and emitted
+    // at power-of-two boundaries up to the largest sample.
+    static void writePrometheus(ostream& out) {
+        for (int c = 0; c < METRIC_COUNTER_TOTAL; c++) {
+            out << "# TYPE universe_" << METRIC_COUNTER_NAMES[c] << "_total counter\n";
+            out << "universe_" << METRIC_COUNTER_NAMES[c] << "_total " << counterTotal((MetricCounter)c) << "\n";
+        }
+
+        out << "# TYPE universe_op_latency_seconds histogram\n";
+        long long* slots = new long long[LATENCY_SLOTS];
+        for (int op = 0; op < METRIC_OP_TOTAL; op++) {
+            long long sum;
+            long long total = mergeLatency((MetricOp)op, slots, sum);
+            long long cumulative = 0;
+            for (int s = 0; s < LATENCY_SLOTS && total > 0; s++) {
+                cumulative += slots[s];
+                if (s % LATENCY_SUB_BUCKETS != LATENCY_SUB_BUCKETS - 1) continue;
+                out << "universe_op_latency_seconds_bucket{op=\"" << METRIC_OP_NAMES[op] << "\",le=\""
+                    << latencySlotEnd(s) / 1e9 << "\"} " << cumulative << "\n";
+                if (cumulative == total) break;
             }
-            cout << endl;
-            current = current->next;
+            out << "universe_op_latency_seconds_bucket{op=\"" << METRIC_OP_NAMES[op] << "\",le=\"+Inf\"} " << total << "\n";
+            out << "universe_op_latency_seconds_sum{op=\"" << METRIC_OP_NAMES[op] << "\"} " << sum / 1e9 << "\n";
+            out << "universe_op_latency_seconds_count{op=\"" << METRIC_OP_NAMES[op] << "\"} " << total << "\n";
         }
+        delete[] slots;
     }
+};
+
+atomic<MetricsBlock*> Metrics::blocks(nullptr);
 
+// Records the enclosing scope's duration under op
+class LatencyTimer {
 private:
-    int getIndex(string name) {
-        Building* current = buildings;
-        int index = 0;
-        while (current) {
-            if (current->name == name) return index;
-            current = current->next;
-            index++;
+    MetricOp op;
+    long long startedAt;
+
+public:
+    LatencyTimer(MetricOp timedOp) : op(timedOp), startedAt(steadyNanos()) {}
+    ~LatencyTimer() {
+        Metrics::record(op, steadyNanos() - startedAt);
+    }
+};
+
+#ifndef UNIVERSE_NO_METRICS
+#define METRICS_ENABLED true
+#define METRIC_COUNT(counter) Metrics::count(counter)
+#define METRIC_RECORD(op, nanos) Metrics::record(op, nanos)
+#define METRIC_TIMER(op) LatencyTimer scopeTimer(op)
+#else
+#define METRICS_ENABLED false
+#define METRIC_COUNT(counter) ((void)0)
+#define METRIC_RECORD(op, nanos) ((void)sizeof(nanos))
+#define METRIC_TIMER(op) ((void)0)
+#endif
+
+// ==================== SNAPSHOT MODULE ====================
+// Consistent versions for long reports. A server worker pins a structure
+// under the system lock, releases the lock and prints from the pinned
+// version while writers carry on. Pinning takes the current epoch and starts
+// a new one; while any reader is pinned, writers leave whatever was stamped
+// at or before the newest pin alone and change copies instead. Replaced
+// nodes are retired with the epoch they left the live version in and
+// released once every pinned reader is newer. Everything here except a
+// reader's unpin runs under the system lock, or on the only thread in
+// interactive and batch mode.
+class EpochDomain {
+private:
+    static const int READER_SLOTS = 64;
+    static const long long IDLE = LLONG_MAX;
+
+    typedef void (*Release)(void* item, void* owner);
+
+    struct Retired {
+        void* item;
+        Release release;
+        void* owner;
+        long long epoch;
+        Retired* next;
+    };
+
+    atomic<long long> readers[READER_SLOTS]; // epoch each pinned reader entered at
+    atomic<int> activeReaders;
+    long long epoch;
+    // First in, first out, so a structure's retired nodes are released
+    // before the structure itself when both are retired
+    Retired* oldest;
+    Retired* newest;
+    int pending;
+
+    long long oldestReader() {
+        long long oldest = IDLE;
+        for (int i = 0; i < READER_SLOTS; i++) {
+            long long entered = readers[i].load(memory_order_acquire);
+            if (entered < oldest) oldest = entered;
         }
-        return -1;
+        return oldest;
     }
 
-    Building* getBuildingByIndex(int index) {
-        Building* current = buildings;
-        int i = 0;
-        while (current && i < index) {
-            current = current->next;
-            i++;
+public:
+    EpochDomain() : activeReaders(0), epoch(1), oldest(nullptr), newest(nullptr), pending(0) {
+        for (int i = 0; i < READER_SLOTS; i++) readers[i].store(IDLE, memory_order_relaxed);
+    }
+
+    // Items still retired at exit belong to structures that are already gone
+    ~EpochDomain() {
+        while (oldest) {
+            Retired* next = oldest->next;
+            delete oldest;
+            oldest = next;
         }
-        return current;
     }
-};
 
-// ==================== AVL TREE/ROOMS MODULE ====================
-struct Room {
-    string id;
-    int floor;
-    string type; // classroom | lab | office
-    bool reserved;
-    string reservedBy;
+    long long current() { return epoch; }
 
-    Room(string i, int f, string t) : id(i), floor(f), type(t), reserved(false), reservedBy("") {}
+    // Returns the reader's slot, or -1 when every slot is taken
+    int enter(long long& pinnedAt) {
+        for (int i = 0; i < READER_SLOTS; i++) {
+            if (readers[i].load(memory_order_acquire) == IDLE) {
+                pinnedAt = epoch++;
+                readers[i].store(pinnedAt, memory_order_release);
+                activeReaders.fetch_add(1, memory_order_relaxed);
+                return i;
+            }
+        }
+        return -1;
+    }
 
-    bool operator<(const Room& other) const { 
-        return id < other.id; 
+    // The one call made without the system lock
+    void leave(int slot) {
+        readers[slot].store(IDLE, memory_order_release);
+        activeReaders.fetch_sub(1, memory_order_release);
     }
-    bool operator>(const Room& other) const { 
-        return id > other.id; 
+
+    // Releases the item now if no reader can hold it, otherwise once every
+    // reader pinned before this point has left
+    void retire(void* item, Release release, void* owner) {
+        if (!oldest && activeReaders.load(memory_order_acquire) == 0) {
+            release(item, owner);
+            return;
+        }
+        Retired* entry = new Retired{ item, release, owner, epoch, nullptr };
+        if (newest) newest->next = entry;
+        else oldest = entry;
+        newest = entry;
+        pending++;
     }
-    bool operator==(const Room& other) const { 
-        return id == other.id; 
+
+    // Returns how many retired items were released
+    int collect() {
+        if (!oldest) return 0;
+        long long horizon = oldestReader();
+        int released = 0;
+        while (oldest && oldest->epoch <= horizon) {
+            Retired* entry = oldest;
+            oldest = entry->next;
+            if (!oldest) newest = nullptr;
+            entry->release(entry->item, entry->owner);
+            delete entry;
+            pending--;
+            released++;
+        }
+        return released;
     }
+
+    int getPending() { return pending; }
 };
 
-struct AVLNode {
-    Room data;
-    AVLNode* left;
-    AVLNode* right;
-    int height;
+EpochDomain snapshotEpochs;
 
-    AVLNode(Room r) : data(r), left(nullptr), right(nullptr), height(1) {}
-};
+template <typename T>
+void releaseToPool(void* item, void* pool) {
+    ((NodePool<T>*)pool)->destroy((T*)item);
+}
 
-class AVLTree {
+template <typename T>
+void releaseArray(void* item, void*) {
+    delete[] (T*)item;
+}
+
+template <typename T>
+void releaseObject(void* item, void*) {
+    delete (T*)item;
+}
+
+struct ReportPin;
+
+// Pin state of one structure
+class VersionGuard {
 private:
-    AVLNode* root;
+    atomic<int> readers;
+    long long frozenAt; // epoch of the newest pin
 
-    int height(AVLNode* node) { 
-        return node ? node->height : 0; 
-    }
-    int max(int a, int b) { 
-        return (a > b) ? a : b; 
-    }
+public:
+    VersionGuard() : readers(0), frozenAt(-1) {}
 
-    int balanceFactor(AVLNode* node) {
-        return node ? height(node->left) - height(node->right) : 0;
+    bool pin(ReportPin& pin);
+
+    void unpin(int slot) {
+        readers.fetch_sub(1, memory_order_release);
+        snapshotEpochs.leave(slot);
     }
 
-    AVLNode* rotateRight(AVLNode* y) {
-        AVLNode* x = y->left;
-        AVLNode* T2 = x->right;
+    bool isPinned() { return readers.load(memory_order_acquire) > 0; }
 
-        x->right = y;
-        y->left = T2;
+    // True when something stamped at this epoch may be in a pinned version
+    bool shared(long long stamp) { return stamp <= frozenAt && isPinned(); }
+};
 
-        y->height = max(height(y->left), height(y->right)) + 1;
-        x->height = max(height(x->left), height(x->right)) + 1;
+// A report pinned to one version of a structure. Filled in under the system
+// lock; printed and released after the lock is dropped.
+struct ReportPin {
+    VersionGuard* guard; // nullptr until something is pinned
+    int slot;
+    long long epoch;
+    const void* version;
+    int size;
+    void (*print)(ostream& out, const ReportPin& pin);
 
-        return x;
+    ReportPin() : guard(nullptr), slot(-1), epoch(0), version(nullptr), size(0), print(nullptr) {}
+
+    void printAndRelease(ostream& out) {
+        print(out, *this);
+        guard->unpin(slot);
+        guard = nullptr;
     }
+};
 
-    AVLNode* rotateLeft(AVLNode* x) {
-        AVLNode* y = x->right;
-        AVLNode* T2 = y->left;
+// False when every reader slot is taken; the report then runs under the lock
+bool VersionGuard::pin(ReportPin& pin) {
+    pin.slot = snapshotEpochs.enter(pin.epoch);
+    if (pin.slot < 0) return false;
+    frozenAt = pin.epoch;
+    readers.fetch_add(1, memory_order_relaxed);
+    pin.guard = this;
+    return true;
+}
 
-        y->left = x;
-        x->right = T2;
+// ==================== HASH TABLE MODULE ====================
+struct Session;
 
-        x->height = max(height(x->left), height(x->right)) + 1;
-        y->height = max(height(y->left), height(y->right)) + 1;
+struct User {
+    string userName;
+    string password;
+    InternedString role; // student | teacher | admin
+    InternedString department;
+    string email;
+    string lastBookedRoom;
+    Session* sessions; // open server sessions, see SessionTable
+    atomic<long long> removedAt; // epoch of a deletion made while a report was pinned, LLONG_MAX if live
+    User* next; // for chaining
+
+    User(string uname, string pwd, string r, string dept, string mail) : userName(uname), password(pwd), role(r), department(dept),  email(mail), lastBookedRoom(""), sessions(nullptr), removedAt(LLONG_MAX), next(nullptr) {}
+
+    bool isLive() const { return removedAt.load(memory_order_relaxed) == LLONG_MAX; }
+};
+
+// Interned once so role checks are a pointer compare
+const InternedString ROLE_ADMIN("admin");
+
+// Reports read a pinned version: the bucket array is copied on the first
+// write after a pin, and users deleted while a reader is pinned stay in their
+// chain as tombstones, since nothing else can stand in for a User. Tombstones
+// are unlinked, and a resize that came due is done, at the first write after
+// the last reader leaves.
+class HashTable {
+private:
+    int capacity;
+    int size;
+    User** table;
+    NodePool<User> pool;
+    VersionGuard versions;
+    long long tableEpoch; // when the bucket array was made
+    int tombstones;
+
+    int hashFunction(string key) {
+        int hash = 0;
+        for (char c : key) {
+            hash = (hash * 31 + c) % capacity;
+        }
+        return hash;
+    }
+
+    void ownTable() {
+        if (!versions.shared(tableEpoch)) return;
+        User** copy = new User * [capacity];
+        for (int i = 0; i < capacity; i++) {
+            copy[i] = table[i];
+        }
+        snapshotEpochs.retire(table, releaseArray<User*>, nullptr);
+        table = copy;
+        tableEpoch = snapshotEpochs.current();
+    }
+
+    // Chains are relinked in place, so only once no reader is pinned
+    void purgeTombstones() {
+        for (int i = 0; i < capacity && tombstones > 0; i++) {
+            User** link = &table[i];
+            while (*link) {
+                User* user = *link;
+                if (user->isLive()) {
+                    link = &user->next;
+                    continue;
+                }
+                *link = user->next;
+                pool.destroy(user);
+                tombstones--;
+            }
+        }
+    }
+
+    void resizeTable() {
+        int oldCapacity = capacity;
+        capacity *= 2;
+        User** newTable = new User * [capacity]();
+
+        for (int i = 0; i < oldCapacity; i++) {
+            User* entry = table[i];
+            while (entry) {
+                User* next = entry->next;
+                int index = hashFunction(entry->userName);
+                entry->next = newTable[index];
+                newTable[index] = entry;
+                entry = next;
+            }
+        }
+        delete[] table;
+        table = newTable;
+    }
+
+public:
+    HashTable(int initialCapacity = 10) : capacity(initialCapacity), size(0), tableEpoch(0), tombstones(0) {
+        table = new User * [capacity]();
+    }
+
+    // Users are released with the pool
+    ~HashTable() {
+        delete[] table;
+    }
+
+    bool registerUser(string userName, string password, string role,
+        string department, string email) {
+        if (searchUser(userName)) {
+            cout << "User already exists!" << endl;
+            return false;
+        }
+
+        bool pinned = versions.isPinned();
+        if (tombstones > 0 && !pinned) {
+            purgeTombstones();
+        }
+        if ((float)size / capacity > 0.7 && !pinned) {
+            resizeTable();
+        }
+        ownTable();
+
+        int index = hashFunction(userName);
+        User* newUser = pool.create(userName, password, role, department, email);
+        newUser->next = table[index];
+        table[index] = newUser;
+        size++;
+        return true;
+    }
+
+    User* login(string userName, string password) {
+        int index = hashFunction(userName);
+        User* user = table[index];
+
+        while (user) {
+            if (user->userName == userName && user->password == password && user->isLive()) {
+                return user;
+            }
+            user = user->next;
+        }
+        return nullptr;
+    }
+
+    User* searchUser(string userName) {
+        int index = hashFunction(userName);
+        User* user = table[index];
+
+        while (user) {
+            if (user->userName == userName && user->isLive()) {
+                return user;
+            }
+            user = user->next;
+        }
+        return nullptr;
+    }
+
+    bool updateUser(string userName, string newPassword,
+        string newDepartment, string newEmail) {
+        User* user = searchUser(userName);
+        if (user) {
+            if (!newPassword.empty()) 
+                user->password = newPassword;
+            if (!newDepartment.empty()) 
+                user->department = newDepartment;
+            if (!newEmail.empty()) 
+                user->email = newEmail;
+            return true;
+        }
+        return false;
+    }
+
+    bool deleteUser(string userName) {
+        if (versions.isPinned()) {
+            User* user = searchUser(userName);
+            if (!user) return false;
+            user->removedAt.store(snapshotEpochs.current(), memory_order_relaxed);
+            tombstones++;
+            size--;
+            return true;
+        }
+        if (tombstones > 0) {
+            purgeTombstones();
+        }
+
+        int index = hashFunction(userName);
+        User* user = table[index];
+        User* prev = nullptr;
+
+        while (user) {
+            if (user->userName == userName) {
+                if (prev) {
+                    prev->next = user->next;
+                }
+                else {
+                    table[index] = user->next;
+                }
+                pool.destroy(user);
+                size--;
+                return true;
+            }
+            prev = user;
+            user = user->next;
+        }
+        return false;
+    }
+
+    // Users deleted at or before the epoch are left out
+    static void printUsers(ostream& out, User* const* buckets, int bucketCount, long long epoch) {
+        for (int i = 0; i < bucketCount; i++) {
+            out << "Bucket " << i << ": ";
+            bool empty = true;
+            for (User* user = buckets[i]; user; user = user->next) {
+                if (user->removedAt.load(memory_order_relaxed) <= epoch) continue;
+                if (!empty) out << " -> ";
+                out << user->userName << "(" << user->role << ")";
+                empty = false;
+            }
+            if (empty) out << "Empty";
+            out << '\n';
+        }
+    }
+
+    static void printVersion(ostream& out, const ReportPin& pin) {
+        printUsers(out, (User* const*)pin.version, pin.size, pin.epoch);
+    }
+
+    void displayAllUsers() {
+        printUsers(cout, table, capacity, snapshotEpochs.current());
+    }
+
+    void forEachUser(void (*visit)(const User& user, void* context), void* context) {
+        for (int i = 0; i < capacity; i++) {
+            for (User* user = table[i]; user; user = user->next) {
+                if (user->isLive()) visit(*user, context);
+            }
+        }
+    }
+
+    bool pinVersion(ReportPin& pin) {
+        if (!versions.pin(pin)) return false;
+        pin.version = table;
+        pin.size = capacity;
+        pin.print = printVersion;
+        return true;
+    }
+
+    void updateLastBookedRoom(string userName, string roomID) {
+        User* user = searchUser(userName);
+        if (user) {
+            user->lastBookedRoom = roomID;
+        }
+    }
+};
+
+// ==================== SESSION MODULE ====================
+// Login sessions for server clients. A session is named by an opaque 128-bit
+// random token (32 hex digits) and found through a chained hash table on the
+// token's low bits, so validating a request is a single probe. Idle expiry
+// runs on a timing wheel of one-second slots: validation only stamps
+// lastSeen, and when the wheel reaches a session's slot the session is either
+// expired or, if it was used since, filed again under its new deadline. A
+// sweep touches only the sessions that are due.
+struct Session {
+    unsigned long long tokenHigh;
+    unsigned long long tokenLow;
+    User* user;
+    long long lastSeen; // seconds
+    int slot;           // wheel slot it is filed under
+    Session* hashNext;
+    Session* wheelNext;
+    Session* wheelPrev;
+    Session* userNext;  // the same user's other sessions
+    Session* userPrev;
+
+    Session(unsigned long long high, unsigned long long low, User* owner, long long now)
+        : tokenHigh(high), tokenLow(low), user(owner), lastSeen(now), slot(-1), hashNext(nullptr),
+        wheelNext(nullptr), wheelPrev(nullptr), userNext(nullptr), userPrev(nullptr) {}
+};
+
+const long long SESSION_IDLE_SECONDS = 30 * 60;
+
+class SessionTable {
+private:
+    static const int WHEEL_SLOTS = 4096; // power of two; one second per slot
+
+    Session** table;
+    int capacity; // power of two
+    int count;
+    Session* wheel[WHEEL_SLOTS];
+    long long sweptUntil; // last second the wheel has processed, -1 before first use
+    long long idleSeconds;
+    long long expiredTotal;
+    NodePool<Session> pool;
+    random_device entropy;
+
+    int bucketOf(unsigned long long tokenLow) {
+        return (int)(tokenLow & (unsigned long long)(capacity - 1));
+    }
+
+    void growTable() {
+        int oldCapacity = capacity;
+        capacity *= 2;
+        Session** newTable = new Session * [capacity]();
+        for (int i = 0; i < oldCapacity; i++) {
+            Session* entry = table[i];
+            while (entry) {
+                Session* next = entry->hashNext;
+                int index = bucketOf(entry->tokenLow);
+                entry->hashNext = newTable[index];
+                newTable[index] = entry;
+                entry = next;
+            }
+        }
+        delete[] table;
+        table = newTable;
+    }
+
+    void file(Session* session) {
+        int slot = (int)((session->lastSeen + idleSeconds) & (WHEEL_SLOTS - 1));
+        session->slot = slot;
+        session->wheelPrev = nullptr;
+        session->wheelNext = wheel[slot];
+        if (wheel[slot]) wheel[slot]->wheelPrev = session;
+        wheel[slot] = session;
+    }
+
+    void unfile(Session* session) {
+        if (session->wheelPrev) session->wheelPrev->wheelNext = session->wheelNext;
+        else wheel[session->slot] = session->wheelNext;
+        if (session->wheelNext) session->wheelNext->wheelPrev = session->wheelPrev;
+    }
+
+    // Drops the session from the hash table and its user's list; the caller unfiles it
+    void release(Session* session) {
+        Session** link = &table[bucketOf(session->tokenLow)];
+        while (*link != session) link = &(*link)->hashNext;
+        *link = session->hashNext;
+
+        if (session->userPrev) session->userPrev->userNext = session->userNext;
+        else session->user->sessions = session->userNext;
+        if (session->userNext) session->userNext->userPrev = session->userPrev;
+
+        pool.destroy(session);
+        count--;
+    }
+
+    Session* find(unsigned long long high, unsigned long long low) {
+        Session* entry = table[bucketOf(low)];
+        while (entry && (entry->tokenLow != low || entry->tokenHigh != high)) entry = entry->hashNext;
+        return entry;
+    }
+
+    Session* find(const string& token) {
+        unsigned long long high, low;
+        return parseToken(token, high, low) ? find(high, low) : nullptr;
+    }
+
+    unsigned long long random64() {
+        return ((unsigned long long)entropy() << 32) ^ entropy();
+    }
+
+public:
+    SessionTable(long long idle) : capacity(64), count(0), sweptUntil(-1), idleSeconds(idle < 1 ? 1 : idle),
+        expiredTotal(0) {
+        table = new Session * [capacity]();
+        for (int i = 0; i < WHEEL_SLOTS; i++) wheel[i] = nullptr;
+    }
+
+    // Sessions are released with the pool
+    ~SessionTable() {
+        delete[] table;
+    }
+
+    static string formatToken(unsigned long long high, unsigned long long low) {
+        char text[33];
+        snprintf(text, sizeof(text), "%016llx%016llx", high, low);
+        return text;
+    }
+
+    static bool parseToken(const string& token, unsigned long long& high, unsigned long long& low) {
+        if (token.size() != 32) return false;
+        high = low = 0;
+        for (int i = 0; i < 32; i++) {
+            char c = token[i];
+            int digit = c >= '0' && c <= '9' ? c - '0' : (c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1);
+            if (digit < 0) return false;
+            unsigned long long& half = i < 16 ? high : low;
+            half = (half << 4) | (unsigned long long)digit;
+        }
+        return true;
+    }
+
+    string open(User* user, long long now) {
+        if (count >= capacity - capacity / 4) {
+            growTable();
+        }
+        unsigned long long high, low;
+        do {
+            high = random64();
+            low = random64();
+        } while (find(high, low));
+
+        Session* session = pool.create(high, low, user, now);
+        int index = bucketOf(low);
+        session->hashNext = table[index];
+        table[index] = session;
+        session->userNext = user->sessions;
+        if (user->sessions) user->sessions->userPrev = session;
+        user->sessions = session;
+        file(session);
+        count++;
+        return formatToken(high, low);
+    }
+
+    // The session's user, or nullptr if the token is unknown or has expired.
+    // A valid token counts as activity.
+    User* validate(const string& token, long long now) {
+        expire(now);
+        Session* session = find(token);
+        if (!session) return nullptr;
+        session->lastSeen = now;
+        return session->user;
+    }
+
+    bool close(const string& token) {
+        Session* session = find(token);
+        if (!session) return false;
+        unfile(session);
+        release(session);
+        return true;
+    }
+
+    // Ends every session of the user, e.g. before the account is deleted
+    int closeAll(User* user) {
+        int closed = 0;
+        while (user->sessions) {
+            unfile(user->sessions);
+            release(user->sessions);
+            closed++;
+        }
+        return closed;
+    }
+
+    // Sweeps the wheel up to now. Returns how many sessions expired.
+    int expire(long long now) {
+        if (sweptUntil < 0 || now - sweptUntil > WHEEL_SLOTS) {
+            sweptUntil = sweptUntil < 0 ? now : now - WHEEL_SLOTS;
+        }
+        int expired = 0;
+        while (sweptUntil < now) {
+            sweptUntil++;
+            int slot = (int)(sweptUntil & (WHEEL_SLOTS - 1));
+            Session* due = wheel[slot];
+            wheel[slot] = nullptr;
+            while (due) {
+                Session* next = due->wheelNext;
+                if (due->lastSeen + idleSeconds <= now) {
+                    release(due);
+                    expired++;
+                }
+                else {
+                    file(due);
+                }
+                due = next;
+            }
+        }
+        expiredTotal += expired;
+        return expired;
+    }
+
+    int getCount() { return count; }
+    long long getExpiredTotal() { return expiredTotal; }
+    long long getIdleSeconds() { return idleSeconds; }
+};
+
+// ==================== GRAPH/CAMPUS MAP MODULE ====================
+struct Edge {
+    InternedString destBuilding;
+    int distance;
+    InternedString pathType;
+    Edge* next;
+
+    Edge(string dest, int dist, string type = "road") : destBuilding(dest), distance(dist), pathType(type), next(nullptr) {}
+};
+
+struct Building {
+    string name;
+    IntrusiveList<Edge> edges; // nodes come from the graph's edge pool
+    Building* next;
+    Building* prev;
+    Building* hashNext; // chain in the name index
+    int visitMark;      // equals the graph's traversal mark once visited
+
+    Building(string n) : name(n), next(nullptr), prev(nullptr), hashNext(nullptr), visitMark(0) {}
+};
+
+class CampusGraph {
+private:
+    IntrusiveList<Building> buildings; // doubly linked, so removal is O(1)
+
+    // Name -> building hash index so lookups stay O(1) on large campuses
+    Building** index;
+    int indexCapacity; // power of two
+    int traversalMark;
+
+    NodePool<Building> buildingPool;
+    NodePool<Edge> edgePool;
+
+    int bucketOf(const string& name) {
+        return hashString(name) & (indexCapacity - 1);
+    }
+
+    void growIndex() {
+        int oldCapacity = indexCapacity;
+        indexCapacity *= 2;
+        Building** newIndex = new Building * [indexCapacity]();
+
+        for (int i = 0; i < oldCapacity; i++) {
+            Building* entry = index[i];
+            while (entry) {
+                Building* next = entry->hashNext;
+                int bucket = bucketOf(entry->name);
+                entry->hashNext = newIndex[bucket];
+                newIndex[bucket] = entry;
+                entry = next;
+            }
+        }
+        delete[] index;
+        index = newIndex;
+    }
+
+    void unindex(Building* building) {
+        Building** link = &index[bucketOf(building->name)];
+        while (*link != building) link = &(*link)->hashNext;
+        *link = building->hashNext;
+    }
+
+    Building* findBuilding(const string& name) {
+        Building* current = index[bucketOf(name)];
+        while (current) {
+            if (current->name == name)
+                return current;
+            current = current->hashNext;
+        }
+        return nullptr;
+    }
+
+    // Removes one edge to dest from building's adjacency list
+    bool unlinkEdge(Building* building, InternedString dest) {
+        Edge* edge = building->edges.unlinkFirst([dest](const Edge& e) { return e.destBuilding == dest; });
+        if (!edge) return false;
+        edgePool.destroy(edge);
+        return true;
+    }
+
+    // Starts a traversal; buildings with visitMark == traversalMark count as visited
+    int beginTraversal() {
+        if (++traversalMark == 0) {
+            for (Building* b = buildings.first(); b; b = b->next) b->visitMark = 0;
+            traversalMark = 1;
+        }
+        return traversalMark;
+    }
+
+public:
+    CampusGraph() : indexCapacity(16), traversalMark(0) {
+        index = new Building * [indexCapacity]();
+    }
+
+    // Buildings and edges are released with their pools
+    ~CampusGraph() {
+        delete[] index;
+    }
+
+    bool addBuilding(string name) {
+        if (findBuilding(name)) {
+            cout << "Building already exists!" << endl;
+            return false;
+        }
+
+        if ((float)buildings.getSize() / indexCapacity > 0.7) {
+            growIndex();
+        }
+
+        Building* newBuilding = buildingPool.create(name);
+        buildings.linkFront(newBuilding);
+
+        int bucket = bucketOf(name);
+        newBuilding->hashNext = index[bucket];
+        index[bucket] = newBuilding;
+        return true;
+    }
+
+    bool removeBuilding(string name) {
+        Building* current = findBuilding(name);
+        if (!current) return false;
+
+        // Paths are undirected, so only this building's neighbours hold edges back to it
+        InternedString removed(name);
+        while (Edge* edge = current->edges.unlinkFront()) {
+            if (edge->destBuilding != removed) {
+                Building* neighbour = findBuilding(edge->destBuilding);
+                if (neighbour) unlinkEdge(neighbour, removed);
+            }
+            edgePool.destroy(edge);
+        }
+
+        buildings.unlink(current);
+        unindex(current);
+        buildingPool.destroy(current);
+        return true;
+    }
+
+    bool addPath(string src, string dest, int distance = 1) {
+        Building* srcBuilding = findBuilding(src);
+        Building* destBuilding = findBuilding(dest);
+
+        if (!srcBuilding || !destBuilding) {
+            cout << "One or both buildings not found!" << endl;
+            return false;
+        }
+
+        // Add edge from src to dest
+        srcBuilding->edges.linkFront(edgePool.create(dest, distance));
+
+        // Add edge from dest to src (undirected)
+        destBuilding->edges.linkFront(edgePool.create(src, distance));
+
+        return true;
+    }
+
+    bool removePath(string src, string dest) {
+        Building* srcBuilding = findBuilding(src);
+        Building* destBuilding = findBuilding(dest);
+
+        if (!srcBuilding || !destBuilding) return false;
+
+        unlinkEdge(srcBuilding, dest);
+        unlinkEdge(destBuilding, src);
+        return true;
+    }
+
+    void BFS(string start) {
+        Building* startBuilding = findBuilding(start);
+        if (!startBuilding) {
+            cout << "Building not found!" << endl;
+            return;
+        }
+
+        // Each building is enqueued at most once
+        Building** queue = new Building * [buildings.getSize()];
+        int mark = beginTraversal();
+        int front = 0, rear = 0;
+
+        queue[rear++] = startBuilding;
+        startBuilding->visitMark = mark;
+
+        cout << "BFS from " << start << ": ";
+
+        while (front < rear) {
+            Building* current = queue[front++];
+            cout << current->name << " ";
+
+            Edge* edge = current->edges.first();
+            while (edge) {
+                Building* adj = findBuilding(edge->destBuilding);
+                if (adj->visitMark != mark) {
+                    queue[rear++] = adj;
+                    adj->visitMark = mark;
+                }
+                edge = edge->next;
+            }
+        }
+        cout << endl;
+        delete[] queue;
+    }
+
+    void DFS(string start) {
+        Building* startBuilding = findBuilding(start);
+        if (!startBuilding) {
+            cout << "Building not found!" << endl;
+            return;
+        }
+
+        // A building can be pushed once per incoming edge, so the stack is
+        // linked; small campuses stay within the inline nodes
+        LinkedStack<Building*, PoolAllocator, 64> stack;
+        int mark = beginTraversal();
+
+        stack.pushFront(startBuilding);
+        cout << "DFS from " << start << ": ";
+
+        while (!stack.isEmpty()) {
+            Building* current = stack.popFront();
+
+            if (current->visitMark != mark) {
+                cout << current->name << " ";
+                current->visitMark = mark;
+            }
+
+            Edge* edge = current->edges.first();
+            while (edge) {
+                Building* adj = findBuilding(edge->destBuilding);
+                if (adj->visitMark != mark) {
+                    stack.pushFront(adj);
+                }
+                edge = edge->next;
+            }
+        }
+        cout << endl;
+    }
+
+    void displayAdjacencyList() {
+        Building* current = buildings.first();
+        while (current) {
+            cout << current->name << " -> ";
+            Edge* edge = current->edges.first();
+            while (edge) {
+                cout << edge->destBuilding << "(" << edge->distance << ")";
+                if (edge->next) cout << " -> ";
+                edge = edge->next;
+            }
+            cout << '\n';
+            current = current->next;
+        }
+    }
+
+    void forEachPath(void (*visit)(const string& from, const Edge& edge, void* context), void* context) {
+        for (Building* current = buildings.first(); current; current = current->next) {
+            for (Edge* edge = current->edges.first(); edge; edge = edge->next) {
+                visit(current->name, *edge, context);
+            }
+        }
+    }
+
+    int getBuildingCount() { return buildings.getSize(); }
+};
+
+// ==================== AVL TREE/ROOMS MODULE ====================
+const int HOURS_PER_DAY = 24;
+const int HOURS_PER_WEEK = 7 * HOURS_PER_DAY;
+
+struct Room {
+    string id;
+    int floor;
+    InternedString type; // classroom | lab | office
+    bool reserved;
+    string reservedBy;
+
+    Room(string i, int f, string t) : id(i), floor(f), type(t), reserved(false), reservedBy("") {}
+
+    bool operator<(const Room& other) const { 
+        return id < other.id; 
+    }
+    bool operator>(const Room& other) const { 
+        return id > other.id; 
+    }
+    bool operator==(const Room& other) const { 
+        return id == other.id; 
+    }
+};
+
+struct AVLNode {
+    Room data;
+    AVLNode* left;
+    AVLNode* right;
+    int height;
+    int bitIndex; // column in the tree's availability bitmap
+    long long epoch; // when the node was made, see EpochDomain
+
+    AVLNode(Room r) : data(r), left(nullptr), right(nullptr), height(1), bitIndex(-1), epoch(0) {}
+};
+
+// While a report has the tree pinned, changes copy the path from the root
+// down to the changed node (path copying); the pinned root keeps the old
+// nodes, which are retired and come back to the pool once the report is done.
+// Unpinned trees change in place. The availability bitmaps are not part of
+// any report and are always updated in place.
+class AVLTree {
+private:
+    AVLNode* root;
+    VersionGuard versions;
+
+    // Deleting and re-inserting rooms recycles pool slots instead of going
+    // back to the global heap
+    NodePool<AVLNode> nodes;
+
+    // Availability bitmap: one row per hour of the week, one bit per room.
+    // busy[hour * bitWords + w] has a bit set when that room is booked for that hour,
+    // so multi-hour queries are a word-wise AND over a few rows.
+    unsigned long long* busy;
+    unsigned long long* present;  // rooms currently in the tree
+    unsigned long long* reservedMask; // rooms held by a whole-room reservation
+    InternedString** slotBookers; // per room, who booked each hour of the week; made on its first booking
+    AVLNode** bitOwner;
+    int* freeBits;
+    int freeBitCount;
+    int nextBit;
+    int bitWords;
+
+    void growBitmap() {
+        int newWords = bitWords ? bitWords * 2 : 1;
+        unsigned long long* newBusy = new unsigned long long[HOURS_PER_WEEK * newWords]();
+        unsigned long long* newPresent = new unsigned long long[newWords]();
+        unsigned long long* newReserved = new unsigned long long[newWords]();
+        AVLNode** newOwner = new AVLNode * [newWords * 64]();
+        InternedString** newBookers = new InternedString * [newWords * 64]();
+        int* newFree = new int[newWords * 64];
+
+        for (int h = 0; h < HOURS_PER_WEEK; h++) {
+            for (int w = 0; w < bitWords; w++) {
+                newBusy[h * newWords + w] = busy[h * bitWords + w];
+            }
+        }
+        for (int w = 0; w < bitWords; w++) {
+            newPresent[w] = present[w];
+            newReserved[w] = reservedMask[w];
+        }
+        for (int i = 0; i < bitWords * 64; i++) {
+            newOwner[i] = bitOwner[i];
+            newBookers[i] = slotBookers[i];
+        }
+        for (int i = 0; i < freeBitCount; i++) {
+            newFree[i] = freeBits[i];
+        }
+
+        delete[] busy;
+        delete[] present;
+        delete[] reservedMask;
+        delete[] bitOwner;
+        delete[] slotBookers;
+        delete[] freeBits;
+        busy = newBusy;
+        present = newPresent;
+        reservedMask = newReserved;
+        bitOwner = newOwner;
+        slotBookers = newBookers;
+        freeBits = newFree;
+        bitWords = newWords;
+    }
+
+    void attachBit(AVLNode* node) {
+        int bit;
+        if (freeBitCount > 0) {
+            bit = freeBits[--freeBitCount];
+        }
+        else {
+            if (nextBit == bitWords * 64) {
+                growBitmap();
+            }
+            bit = nextBit++;
+        }
+        node->bitIndex = bit;
+        bitOwner[bit] = node;
+        present[bit >> 6] |= 1ULL << (bit & 63);
+    }
+
+    void detachBit(AVLNode* node) {
+        int bit = node->bitIndex;
+        unsigned long long keep = ~(1ULL << (bit & 63));
+        for (int h = 0; h < HOURS_PER_WEEK; h++) {
+            busy[h * bitWords + (bit >> 6)] &= keep;
+        }
+        present[bit >> 6] &= keep;
+        reservedMask[bit >> 6] &= keep;
+        delete[] slotBookers[bit];
+        slotBookers[bit] = nullptr;
+        bitOwner[bit] = nullptr;
+        freeBits[freeBitCount++] = bit;
+    }
+
+    bool validSlotRange(int day, int fromHour, int toHour) {
+        return day >= 0 && day < 7 && fromHour >= 0 && toHour < HOURS_PER_DAY && fromHour <= toHour;
+    }
+
+    // Fills mask with rooms that are free for every hour in the range; returns how many
+    int freeMask(int day, int fromHour, int toHour, unsigned long long* mask) {
+        for (int w = 0; w < bitWords; w++) {
+            mask[w] = present[w] & ~reservedMask[w];
+        }
+        for (int h = day * HOURS_PER_DAY + fromHour; h <= day * HOURS_PER_DAY + toHour; h++) {
+            const unsigned long long* row = busy + h * bitWords;
+            for (int w = 0; w < bitWords; w++) {
+                mask[w] &= ~row[w];
+            }
+        }
+        int count = 0;
+        for (int w = 0; w < bitWords; w++) {
+            count += popCount64(mask[w]);
+        }
+        return count;
+    }
+
+    template <typename... Args>
+    AVLNode* createNode(Args&&... args) {
+        AVLNode* node = nodes.create(forward<Args>(args)...);
+        node->epoch = snapshotEpochs.current();
+        return node;
+    }
+
+    // The node itself, or a copy standing in for it if a pinned version may hold it
+    AVLNode* own(AVLNode* node) {
+        if (!versions.shared(node->epoch)) return node;
+        AVLNode* copy = createNode(*node);
+        bitOwner[copy->bitIndex] = copy;
+        snapshotEpochs.retire(node, releaseToPool<AVLNode>, &nodes);
+        return copy;
+    }
+
+    void discard(AVLNode* node) {
+        if (versions.shared(node->epoch)) snapshotEpochs.retire(node, releaseToPool<AVLNode>, &nodes);
+        else nodes.destroy(node);
+    }
+
+    // Owns every node from here down to roomID; found is the owned room node
+    AVLNode* copyPath(AVLNode* node, const string& roomID, AVLNode*& found) {
+        node = own(node);
+        if (roomID < node->data.id) node->left = copyPath(node->left, roomID, found);
+        else if (roomID > node->data.id) node->right = copyPath(node->right, roomID, found);
+        else found = node;
+        return node;
+    }
+
+    AVLNode* writable(AVLNode* node) {
+        if (!versions.shared(node->epoch)) return node;
+        AVLNode* found = nullptr;
+        root = copyPath(root, node->data.id, found);
+        return found;
+    }
+
+    int height(AVLNode* node) { 
+        return node ? node->height : 0; 
+    }
+    int max(int a, int b) { 
+        return (a > b) ? a : b; 
+    }
+
+    int balanceFactor(AVLNode* node) {
+        return node ? height(node->left) - height(node->right) : 0;
+    }
+
+    // Rotations expect their argument to be owned already
+    AVLNode* rotateRight(AVLNode* y) {
+        AVLNode* x = own(y->left);
+        AVLNode* T2 = x->right;
+
+        x->right = y;
+        y->left = T2;
+
+        y->height = max(height(y->left), height(y->right)) + 1;
+        x->height = max(height(x->left), height(x->right)) + 1;
+
+        return x;
+    }
+
+    AVLNode* rotateLeft(AVLNode* x) {
+        AVLNode* y = own(x->right);
+        AVLNode* T2 = y->left;
+
+        y->left = x;
+        x->right = T2;
+
+        x->height = max(height(x->left), height(x->right)) + 1;
+        y->height = max(height(y->left), height(y->right)) + 1;
+
+        return y;
+    }
+
+    // Expects the node to be owned already
+    AVLNode* rebalance(AVLNode* node) {
+        node->height = 1 + max(height(node->left), height(node->right));
+        int balance = balanceFactor(node);
+
+        if (balance > 1) {
+            // Left Right
+            if (balanceFactor(node->left) < 0) {
+                node->left = rotateLeft(own(node->left));
+            }
+            return rotateRight(node);
+        }
+        if (balance < -1) {
+            // Right Left
+            if (balanceFactor(node->right) > 0) {
+                node->right = rotateRight(own(node->right));
+            }
+            return rotateLeft(node);
+        }
+        return node;
+    }
+
+    AVLNode* insert(AVLNode* node, Room room) {
+        if (!node) {
+            AVLNode* newNode = createNode(room);
+            attachBit(newNode);
+            return newNode;
+        }
+
+        node = own(node);
+        if (room < node->data) {
+            node->left = insert(node->left, room);
+        }
+        else if (room > node->data) {
+            node->right = insert(node->right, room);
+        }
+        else {
+            return node; 
+        }
+
+        node->height = 1 + max(height(node->left), height(node->right));
+        int balance = balanceFactor(node);
+
+        // Left Left
+        if (balance > 1 && room < node->left->data) {
+            return rotateRight(node);
+        }
+        // Right Right
+        if (balance < -1 && room > node->right->data) {
+            return rotateLeft(node);
+        }
+        // Left Right
+        if (balance > 1 && room > node->left->data) {
+            node->left = rotateLeft(own(node->left));
+            return rotateRight(node);
+        }
+        // Right Left
+        if (balance < -1 && room < node->right->data) {
+            node->right = rotateRight(own(node->right));
+            return rotateLeft(node);
+        }
+
+        return node;
+    }
+
+    // Unlinks the smallest node of the subtree into minNode and returns the rebalanced subtree
+    AVLNode* detachMin(AVLNode* node, AVLNode*& minNode) {
+        if (!node->left) {
+            minNode = node;
+            return node->right;
+        }
+        node = own(node);
+        node->left = detachMin(node->left, minNode);
+        return rebalance(node);
+    }
+
+    // Nodes on the path are only owned once the room is known to be below them
+    AVLNode* remove(AVLNode* node, string roomID, bool& removed) {
+        if (!node) return nullptr;
+
+        if (roomID < node->data.id) {
+            AVLNode* left = remove(node->left, roomID, removed);
+            if (!removed) return node;
+            node = own(node);
+            node->left = left;
+        }
+        else if (roomID > node->data.id) {
+            AVLNode* right = remove(node->right, roomID, removed);
+            if (!removed) return node;
+            node = own(node);
+            node->right = right;
+        }
+        else {
+            removed = true;
+            detachBit(node);
+            if (!node->left || !node->right) {
+                AVLNode* child = node->left ? node->left : node->right;
+                discard(node);
+                return child;
+            }
+
+            // Two children: relink the inorder successor in place of this node
+            AVLNode* successor = nullptr;
+            AVLNode* newRight = detachMin(node->right, successor);
+            successor = own(successor);
+            successor->left = node->left;
+            successor->right = newRight;
+            discard(node);
+            return rebalance(successor);
+        }
+
+        return rebalance(node);
+    }
+
+    AVLNode* search(AVLNode* node, string roomID) {
+        if (!node || node->data.id == roomID) 
+            return node;
+
+        if (roomID < node->data.id) {
+            return search(node->left, roomID);
+        }
+        return search(node->right, roomID);
+    }
+
+    static void inorder(ostream& out, const AVLNode* node) {
+        if (node) {
+            inorder(out, node->left);
+            out << "Room: " << node->data.id << " (Floor: " << node->data.floor << ", Type: " << node->data.type << ", Reserved: " << (node->data.reserved ? "Yes" : "No") << ")\n";
+            inorder(out, node->right);
+        }
+    }
+
+    static void printVersion(ostream& out, const ReportPin& pin) {
+        out << "=== Rooms (Inorder) ===" << endl;
+        inorder(out, (const AVLNode*)pin.version);
+    }
+
+    void forEach(AVLNode* node, void (*visit)(const Room& room, void* context), void* context) {
+        if (node) {
+            forEach(node->left, visit, context);
+            visit(node->data, context);
+            forEach(node->right, visit, context);
+        }
+    }
+
+    void searchByType(AVLNode* node, InternedString type, int& count) {
+        if (node) {
+            if (node->data.type == type) {
+                count++;
+                cout << "Room: " << node->data.id << " (Floor: " << node->data.floor << ")" << endl;
+            }
+            searchByType(node->left, type, count);
+            searchByType(node->right, type, count);
+        }
+    }
+
+public:
+    AVLTree() : root(nullptr), busy(nullptr), present(nullptr),
+        reservedMask(nullptr), slotBookers(nullptr), bitOwner(nullptr), freeBits(nullptr), freeBitCount(0), nextBit(0), bitWords(0) {
+        growBitmap();
+    }
+
+    // Nodes are released with the pool
+    ~AVLTree() {
+        delete[] busy;
+        delete[] present;
+        delete[] reservedMask;
+        for (int i = 0; i < bitWords * 64; i++) {
+            delete[] slotBookers[i];
+        }
+        delete[] slotBookers;
+        delete[] bitOwner;
+        delete[] freeBits;
+    }
+
+    // Returns false when a room with this ID already exists
+    bool insertRoom(Room room) {
+        if (search(root, room.id)) return false;
+        root = insert(root, room);
+        return true;
+    }
+
+    void forEachRoom(void (*visit)(const Room& room, void* context), void* context) {
+        forEach(root, visit, context);
+    }
+
+    bool deleteRoom(string roomID) {
+        bool removed = false;
+        root = remove(root, roomID, removed);
+        return removed;
+    }
+
+    Room* searchRoom(string roomID) {
+        AVLNode* node = search(root, roomID);
+        return node ? &(node->data) : nullptr;
+    }
+
+    bool reserveRoom(string roomID, string userName) {
+        AVLNode* node = search(root, roomID);
+        if (node && !node->data.reserved) {
+            node = writable(node);
+            node->data.reserved = true;
+            node->data.reservedBy = userName;
+            int bit = node->bitIndex;
+            reservedMask[bit >> 6] |= 1ULL << (bit & 63);
+            return true;
+        }
+        return false;
+    }
+
+    bool cancelReservation(string roomID) {
+        AVLNode* node = search(root, roomID);
+        if (node && node->data.reserved) {
+            node = writable(node);
+            node->data.reserved = false;
+            node->data.reservedBy = "";
+            int bit = node->bitIndex;
+            reservedMask[bit >> 6] &= ~(1ULL << (bit & 63));
+            return true;
+        }
+        return false;
+    }
+
+    // day: 0 = Monday .. 6 = Sunday, hours are inclusive
+    bool reserveSlots(string roomID, int day, int fromHour, int toHour, const string& userName) {
+        AVLNode* node = search(root, roomID);
+        if (!node || !validSlotRange(day, fromHour, toHour)) return false;
+
+        int word = node->bitIndex >> 6;
+        unsigned long long bit = 1ULL << (node->bitIndex & 63);
+        for (int h = day * HOURS_PER_DAY + fromHour; h <= day * HOURS_PER_DAY + toHour; h++) {
+            if (busy[h * bitWords + word] & bit) return false;
+        }
+        InternedString*& bookers = slotBookers[node->bitIndex];
+        if (!bookers) bookers = new InternedString[HOURS_PER_WEEK];
+        InternedString booker(userName);
+        for (int h = day * HOURS_PER_DAY + fromHour; h <= day * HOURS_PER_DAY + toHour; h++) {
+            busy[h * bitWords + word] |= bit;
+            bookers[h] = booker;
+        }
+        return true;
+    }
+
+    // Fails unless every hour in the range is booked, and booked by userName
+    // when anyBooker is false
+    bool cancelSlots(string roomID, int day, int fromHour, int toHour, const string& userName, bool anyBooker) {
+        AVLNode* node = search(root, roomID);
+        if (!node || !validSlotRange(day, fromHour, toHour)) return false;
+
+        int word = node->bitIndex >> 6;
+        unsigned long long bit = 1ULL << (node->bitIndex & 63);
+        const InternedString* bookers = slotBookers[node->bitIndex];
+        InternedString booker;
+        if (!anyBooker && !InternedString::find(userName, booker)) return false;
+        for (int h = day * HOURS_PER_DAY + fromHour; h <= day * HOURS_PER_DAY + toHour; h++) {
+            if (!(busy[h * bitWords + word] & bit)) return false;
+            if (!anyBooker && bookers[h] != booker) return false;
+        }
+        for (int h = day * HOURS_PER_DAY + fromHour; h <= day * HOURS_PER_DAY + toHour; h++) {
+            busy[h * bitWords + word] &= ~bit;
+        }
+        return true;
+    }
+
+    int countFreeRooms(int day, int fromHour, int toHour) {
+        if (!validSlotRange(day, fromHour, toHour)) return 0;
+        unsigned long long* mask = new unsigned long long[bitWords];
+        int count = freeMask(day, fromHour, toHour, mask);
+        delete[] mask;
+        return count;
+    }
+
+    void displayFreeRooms(int day, int fromHour, int toHour) {
+        if (!validSlotRange(day, fromHour, toHour)) {
+            cout << "Invalid day or hour range!" << endl;
+            return;
+        }
+        unsigned long long* mask = new unsigned long long[bitWords];
+        int count = freeMask(day, fromHour, toHour, mask);
+        cout << "=== Free rooms (" << count << ") ===" << endl;
+        for (int w = 0; w < bitWords; w++) {
+            unsigned long long bits = mask[w];
+            while (bits) {
+                AVLNode* node = bitOwner[w * 64 + lowestBit64(bits)];
+                cout << "Room: " << node->data.id << " (Floor: " << node->data.floor << ", Type: " << node->data.type << ")" << endl;
+                bits &= bits - 1;
+            }
+        }
+        delete[] mask;
+    }
+
+    void displayInorder() {
+        cout << "=== Rooms (Inorder) ===" << endl;
+        inorder(cout, root);
+    }
+
+    bool pinVersion(ReportPin& pin) {
+        if (!versions.pin(pin)) return false;
+        pin.version = root;
+        pin.print = printVersion;
+        return true;
+    }
+
+    void displayByType(string type) {
+        cout << "=== Rooms of type: " << type << " ===" << endl;
+        int count = 0;
+        InternedString wanted;
+        if (InternedString::find(type, wanted)) {
+            searchByType(root, wanted, count);
+        }
+        if (count == 0) {
+            cout << "No rooms found of this type." << endl;
+        }
+    }
+
+    bool isEmpty() { return root == nullptr; }
+};
+
+// ==================== FULL-TEXT SEARCH MODULE ====================
+const int SEARCH_RESULTS_SHOWN = 50;
+
+// Splits text into lowercase alphanumeric words; returns false when none are left
+bool nextToken(const string& text, size_t& pos, string& token) {
+    token.clear();
+    while (pos < text.size()) {
+        char c = text[pos++];
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+            token += c;
+        }
+        else if (!token.empty()) {
+            break;
+        }
+    }
+    return !token.empty();
+}
+
+// Postings for one term: increasing document IDs stored as varint deltas,
+// with a skip entry every SKIP_INTERVAL postings so AND queries can jump
+// over long lists instead of decoding them end to end.
+struct PostingList {
+    static const int SKIP_INTERVAL = 64;
+
+    string term;
+    unsigned char* bytes;
+    int length;
+    int capacity;
+    int count;
+    int lastDoc;
+    int* skipDocs;    // doc decoded just before each skip block (-1 for the first)
+    int* skipOffsets; // byte offset where each skip block starts
+    int skipCount;
+    int skipCapacity;
+    PostingList* next; // for chaining
+
+    PostingList(string t) : term(t), length(0), capacity(16), count(0), lastDoc(-1),
+        skipCount(0), skipCapacity(4), next(nullptr) {
+        bytes = new unsigned char[capacity];
+        skipDocs = new int[skipCapacity];
+        skipOffsets = new int[skipCapacity];
+    }
+
+    ~PostingList() {
+        delete[] bytes;
+        delete[] skipDocs;
+        delete[] skipOffsets;
+    }
+
+    void append(int doc) {
+        if (count % SKIP_INTERVAL == 0) {
+            if (skipCount == skipCapacity) {
+                int* newDocs = new int[skipCapacity * 2];
+                int* newOffsets = new int[skipCapacity * 2];
+                for (int i = 0; i < skipCount; i++) {
+                    newDocs[i] = skipDocs[i];
+                    newOffsets[i] = skipOffsets[i];
+                }
+                delete[] skipDocs;
+                delete[] skipOffsets;
+                skipDocs = newDocs;
+                skipOffsets = newOffsets;
+                skipCapacity *= 2;
+            }
+            skipDocs[skipCount] = lastDoc;
+            skipOffsets[skipCount] = length;
+            skipCount++;
+        }
+
+        if (length + 5 > capacity) {
+            unsigned char* newBytes = new unsigned char[capacity * 2];
+            for (int i = 0; i < length; i++) {
+                newBytes[i] = bytes[i];
+            }
+            delete[] bytes;
+            bytes = newBytes;
+            capacity *= 2;
+        }
+
+        unsigned int delta = (unsigned int)(doc - lastDoc);
+        while (delta >= 0x80) {
+            bytes[length++] = (unsigned char)(delta | 0x80);
+            delta >>= 7;
+        }
+        bytes[length++] = (unsigned char)delta;
+        lastDoc = doc;
+        count++;
+    }
+};
+
+// Forward-only reader over a posting list
+struct PostingCursor {
+    PostingList* list;
+    int offset;
+    int doc; // current document, or -1 before the first read
+
+    PostingCursor() : list(nullptr), offset(0), doc(-1) {}
+    PostingCursor(PostingList* l) : list(l), offset(0), doc(-1) {}
+
+    bool advance() {
+        if (offset >= list->length) return false;
+        unsigned int delta = 0;
+        int shift = 0;
+        unsigned char b;
+        do {
+            b = list->bytes[offset++];
+            delta |= (unsigned int)(b & 0x7F) << shift;
+            shift += 7;
+        } while (b & 0x80);
+        doc += (int)delta;
+        return true;
+    }
+
+    // Moves to the first document >= target; false when the list runs out
+    bool seek(int target) {
+        if (doc >= target) return true;
+
+        int lo = 0, hi = list->skipCount - 1, best = -1;
+        while (lo <= hi) {
+            int mid = (lo + hi) / 2;
+            if (list->skipDocs[mid] < target) {
+                best = mid;
+                lo = mid + 1;
+            }
+            else {
+                hi = mid - 1;
+            }
+        }
+        if (best >= 0 && list->skipOffsets[best] > offset) {
+            offset = list->skipOffsets[best];
+            doc = list->skipDocs[best];
+        }
+
+        while (doc < target) {
+            if (!advance()) return false;
+        }
+        return true;
+    }
+};
+
+class InvertedIndex {
+private:
+    static const int MAX_QUERY_TERMS = 16;
+
+    PostingList** table;
+    int capacity; // power of two
+    int termCount;
+    NodePool<PostingList> lists;
+
+    // Removed documents stay in the posting lists and are filtered through this
+    // bitmap until enough pile up to make a compaction worthwhile
+    unsigned long long* removed;
+    int removedWords;
+    int liveDocs;
+    int removedSinceCompact;
+
+    PostingList* findList(const string& term) {
+        PostingList* list = table[hashString(term) & (capacity - 1)];
+        while (list && list->term != term) {
+            list = list->next;
+        }
+        return list;
+    }
+
+    PostingList* findOrCreateList(const string& term) {
+        PostingList* list = findList(term);
+        if (list) return list;
+
+        if (termCount > capacity - capacity / 4) {
+            int oldCapacity = capacity;
+            PostingList** oldTable = table;
+            capacity *= 2;
+            table = new PostingList * [capacity]();
+            for (int i = 0; i < oldCapacity; i++) {
+                PostingList* entry = oldTable[i];
+                while (entry) {
+                    PostingList* next = entry->next;
+                    int index = hashString(entry->term) & (capacity - 1);
+                    entry->next = table[index];
+                    table[index] = entry;
+                    entry = next;
+                }
+            }
+            delete[] oldTable;
+        }
+
+        int index = hashString(term) & (capacity - 1);
+        list = lists.create(term);
+        list->next = table[index];
+        table[index] = list;
+        termCount++;
+        return list;
+    }
+
+    bool isRemoved(int doc) {
+        int word = doc >> 6;
+        return word < removedWords && (removed[word] >> (doc & 63)) & 1ULL;
+    }
+
+    // Rewrites every posting list without removed documents
+    void compact() {
+        for (int i = 0; i < capacity; i++) {
+            PostingList** link = &table[i];
+            while (*link) {
+                PostingList* old = *link;
+                PostingList* fresh = lists.create(old->term);
+                PostingCursor cursor(old);
+                while (cursor.advance()) {
+                    if (!isRemoved(cursor.doc)) fresh->append(cursor.doc);
+                }
+                fresh->next = old->next;
+                lists.destroy(old);
+                if (fresh->count == 0) {
+                    *link = fresh->next;
+                    lists.destroy(fresh);
+                    termCount--;
+                }
+                else {
+                    *link = fresh;
+                    link = &fresh->next;
+                }
+            }
+        }
+        removedSinceCompact = 0;
+    }
+
+public:
+    InvertedIndex() : capacity(256), termCount(0), removed(nullptr), removedWords(0), liveDocs(0), removedSinceCompact(0) {
+        table = new PostingList * [capacity]();
+    }
+
+    // Posting lists are released with the pool
+    ~InvertedIndex() {
+        delete[] table;
+        delete[] removed;
+    }
+
+    // Document IDs must be added in increasing order
+    void addDocument(int doc, const string& text) {
+        size_t pos = 0;
+        string token;
+        while (nextToken(text, pos, token)) {
+            PostingList* list = findOrCreateList(token);
+            if (list->lastDoc != doc) list->append(doc);
+        }
+        liveDocs++;
+    }
+
+    void removeDocument(int doc) {
+        int word = doc >> 6;
+        if (word >= removedWords) {
+            int newWords = removedWords ? removedWords : 16;
+            while (newWords <= word) newWords *= 2;
+            unsigned long long* newRemoved = new unsigned long long[newWords]();
+            for (int i = 0; i < removedWords; i++) {
+                newRemoved[i] = removed[i];
+            }
+            delete[] removed;
+            removed = newRemoved;
+            removedWords = newWords;
+        }
+        removed[word] |= 1ULL << (doc & 63);
+        liveDocs--;
+        removedSinceCompact++;
+        if (removedSinceCompact > 4096 && removedSinceCompact > liveDocs) {
+            compact();
+        }
+    }
+
+    // Documents containing every query word, in increasing ID order. Fills up
+    // to maxResults IDs and returns the total number of matches.
+    int search(const string& query, int* results, int maxResults) {
+        PostingCursor cursors[MAX_QUERY_TERMS];
+        int termTotal = 0;
+        size_t pos = 0;
+        string token;
+        while (nextToken(query, pos, token) && termTotal < MAX_QUERY_TERMS) {
+            PostingList* list = findList(token);
+            if (!list) return 0;
+
+            bool duplicate = false;
+            for (int i = 0; i < termTotal; i++) {
+                if (cursors[i].list == list) duplicate = true;
+            }
+            if (duplicate) continue;
+
+            // Keep cursors ordered by list length, shortest first
+            int at = termTotal++;
+            while (at > 0 && cursors[at - 1].list->count > list->count) {
+                cursors[at] = cursors[at - 1];
+                at--;
+            }
+            cursors[at] = PostingCursor(list);
+        }
+        if (termTotal == 0) return 0;
+
+        int matches = 0;
+        while (cursors[0].advance()) {
+            int candidate = cursors[0].doc;
+            bool all = true;
+            for (int i = 1; i < termTotal && all; i++) {
+                if (!cursors[i].seek(candidate)) return matches;
+                if (cursors[i].doc != candidate) all = false;
+            }
+            if (all && !isRemoved(candidate)) {
+                if (matches < maxResults) results[matches] = candidate;
+                matches++;
+            }
+        }
+        return matches;
+    }
+
+    int getTermCount() { return termCount; }
+    int getDocumentCount() { return liveDocs; }
+};
+
+// ==================== QUEUE/COMPLAINTS MODULE ====================
+// Reduces a description to its sorted set of lowercase words (3+ letters,
+// or 2 written in capitals such as "AC"), so "Projector is not working!" and
+// "projector not working" match. A description with no such words keys on
+// its whole lowercased text, so short reports don't all collapse into "".
+string normalizeDescription(const string& text) {
+    string words[32];
+    int count = 0;
+    string word;
+    bool capitals = true;
+    for (size_t i = 0; i <= text.size(); i++) {
+        char c = i < text.size() ? text[i] : ' ';
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+            word += c;
+            if (c >= 'a') capitals = false;
+        }
+        else if (c >= 'A' && c <= 'Z') {
+            word += (char)(c - 'A' + 'a');
+        }
+        else {
+            if ((word.size() >= 3 || (word.size() == 2 && capitals)) && count < 32) {
+                int pos = count++;
+                while (pos > 0 && words[pos - 1] > word) {
+                    words[pos] = words[pos - 1];
+                    pos--;
+                }
+                words[pos] = word;
+            }
+            word.clear();
+            capitals = true;
+        }
+    }
+
+    if (count == 0) {
+        string lowered;
+        for (char c : text) lowered += (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+        return lowered;
+    }
+
+    string normalized;
+    for (int i = 0; i < count; i++) {
+        if (i > 0 && words[i] == words[i - 1]) continue;
+        if (!normalized.empty()) normalized += ' ';
+        normalized += words[i];
+    }
+    return normalized;
+}
+
+struct Complaint {
+    int id;
+    string raisedBy;
+    InternedString building;
+    string room;
+    string description;
+    long long time; // epoch milliseconds, see CampusClock
+    int severity; // 1 (minor) .. 5 (safety critical)
+    int reporters; // users whose duplicate complaints were folded into this one
+
+    Complaint() : id(0), time(0), severity(1), reporters(1) {}
+
+    Complaint(int i, string user, string bldg, string rm, string desc, long long t, int sev = 1)
+        : id(i), raisedBy(user), building(bldg), room(rm), description(desc), time(t), severity(sev), reporters(1) {
+    }
+
+    void display(ostream& out = cout) const {
+        out << "Complaint #" << id << " (Severity " << severity << ")";
+        if (reporters > 1) out << " - reported by " << reporters << " users";
+        out << '\n';
+        out << "From: " << raisedBy << " | Building: " << building
+            << " | Room: " << room << '\n';
+        out << "Issue: " << description << '\n';
+        out << "Time: " << formatTimestamp(time) << '\n';
+        out << "------------------------\n";
+    }
+};
+
+enum ComplaintIndexSlot { BY_BUILDING = 0, BY_LOCATION = 1 };
+
+struct ComplaintNode {
+    Complaint data;
+    ComplaintNode* next;
+    ComplaintNode* prev;
+    long long priorityKey; // lower is served first in priority mode
+    int heapIndex;
+    long long queuedAt; // steadyNanos() at enqueue
+    string normalized; // description key used for coalescing
+    string foldedBy;   // users whose reports were folded in, each followed by '\n'
+    ComplaintNode* indexNext[2]; // chains in the building and building/room indexes
+    ComplaintNode* indexPrev[2];
+
+    ComplaintNode() : next(nullptr), prev(nullptr), priorityKey(0), heapIndex(-1), queuedAt(0) {
+        indexNext[0] = indexNext[1] = nullptr;
+        indexPrev[0] = indexPrev[1] = nullptr;
+    }
+};
+
+// Hash index over open complaints, chained intrusively through the nodes so
+// insert and remove are O(1). Keyed by building or by building + room.
+class ComplaintIndex {
+private:
+    int slot;
+    ComplaintNode** buckets;
+    int capacity;
+    int count;
+
+    // FNV-1a over the building, then a separator and the room for BY_LOCATION,
+    // without building the combined key
+    int bucketOf(const string& building, const string& room) {
+        unsigned int hash = hashString(building);
+        if (slot != BY_BUILDING) {
+            hash = (hash ^ 0x1fu) * 16777619u;
+            for (char c : room) {
+                hash = (hash ^ (unsigned char)c) * 16777619u;
+            }
+        }
+        return hash & (capacity - 1);
+    }
+
+    bool matches(const ComplaintNode* node, const InternedString& building, const string& room) {
+        return node->data.building == building && (slot == BY_BUILDING || node->data.room == room);
+    }
+
+    void resize() {
+        ComplaintNode** oldBuckets = buckets;
+        int oldCapacity = capacity;
+        capacity *= 2;
+        buckets = new ComplaintNode * [capacity]();
+        for (int i = 0; i < oldCapacity; i++) {
+            ComplaintNode* node = oldBuckets[i];
+            while (node) {
+                ComplaintNode* next = node->indexNext[slot];
+                link(node);
+                node = next;
+            }
+        }
+        delete[] oldBuckets;
+    }
+
+    void link(ComplaintNode* node) {
+        int index = bucketOf(node->data.building, node->data.room);
+        node->indexPrev[slot] = nullptr;
+        node->indexNext[slot] = buckets[index];
+        if (buckets[index]) buckets[index]->indexPrev[slot] = node;
+        buckets[index] = node;
+    }
+
+public:
+    ComplaintIndex(int indexSlot) : slot(indexSlot), capacity(64), count(0) {
+        buckets = new ComplaintNode * [capacity]();
+    }
+
+    ~ComplaintIndex() {
+        delete[] buckets;
+    }
+
+    void insert(ComplaintNode* node) {
+        if (count >= capacity - capacity / 4) {
+            resize();
+        }
+        link(node);
+        count++;
+    }
+
+    void remove(ComplaintNode* node) {
+        if (node->indexPrev[slot]) {
+            node->indexPrev[slot]->indexNext[slot] = node->indexNext[slot];
+        }
+        else {
+            buckets[bucketOf(node->data.building, node->data.room)] = node->indexNext[slot];
+        }
+        if (node->indexNext[slot]) {
+            node->indexNext[slot]->indexPrev[slot] = node->indexPrev[slot];
+        }
+        count--;
+    }
+
+    // First node at the location (room is ignored when keyed by building);
+    // continue with findNext
+    ComplaintNode* findFirst(const InternedString& building, const string& room) {
+        return skipTo(buckets[bucketOf(building, room)], building, room);
+    }
+
+    ComplaintNode* findNext(ComplaintNode* node, const InternedString& building, const string& room) {
+        return skipTo(node->indexNext[slot], building, room);
+    }
+
+private:
+    ComplaintNode* skipTo(ComplaintNode* node, const InternedString& building, const string& room) {
+        while (node && !matches(node, building, room)) {
+            node = node->indexNext[slot];
+        }
+        return node;
+    }
+};
+
+// Open complaints in arrival order, copied for reports. The open list is
+// doubly linked and nodes are recycled and escalated in place, so instead of
+// path copying a pinned report gets a copy of the records made at pin time,
+// which later reports share until the queue changes.
+struct ComplaintSnapshot {
+    Complaint* items;
+    int count;
+
+    ComplaintSnapshot(int capacity) : items(new Complaint[capacity > 0 ? capacity : 1]), count(0) {}
+    ~ComplaintSnapshot() { delete[] items; }
+};
+
+class ComplaintQueue {
+private:
+    IntrusiveList<ComplaintNode> open; // arrival order, doubly linked
+    int nextID;
+
+    VersionGuard versions;
+    ComplaintSnapshot* published; // copy of the open list as of publishedAt
+    long long changes;
+    long long publishedAt;
+
+    // Priority mode keeps the same nodes in a 4-ary min-heap on priorityKey.
+    // The key is arrival order minus AGING_STEP per severity level, so a higher
+    // severity jumps ahead of at most AGING_STEP arrivals per level and an old
+    // minor complaint still reaches the front eventually.
+    static const int HEAP_ARITY = 4;
+    static const int AGING_STEP = 50;
+
+    bool priorityMode;
+    ComplaintNode** heap;
+    int heapCapacity;
+    long long arrivals;
+
+    // IDs are handed out sequentially, so the ID index is a plain array
+    ComplaintNode** byID;
+    int byIDCapacity;
+
+    ComplaintIndex byBuilding;
+    ComplaintIndex byLocation;
+
+    // Open complaints by filing time. Entries are appended as complaints are
+    // filed, and the clock never runs backwards, so the array stays sorted and
+    // a time range is found by binary search. Entries of complaints that have
+    // left the queue (their byID slot is empty) are skipped, and squeezed out
+    // once they outnumber the live ones.
+    struct TimelineEntry {
+        long long time;
+        int id;
+    };
+    TimelineEntry* timeline;
+    int timelineCount;
+    int timelineCapacity;
+    int timelineDead;
+
+    // Processed nodes are kept constructed for reuse, so a queue in steady
+    // state stops allocating and their strings keep their capacity. Open and
+    // spare nodes alike are released with the pool.
+    NodePool<ComplaintNode> nodes;
+    IntrusiveList<ComplaintNode> spareNodes;
+
+    InvertedIndex descriptionIndex; // open complaints only
+
+    ComplaintNode* acquireNode() {
+        ComplaintNode* node = spareNodes.unlinkFront();
+        return node ? node : nodes.create();
+    }
+
+    void recycleNode(ComplaintNode* node) {
+        node->heapIndex = -1;
+        spareNodes.linkFront(node);
+    }
+
+    long long computeKey(ComplaintNode* node, long long arrival) {
+        return arrival - (long long)node->data.severity * AGING_STEP;
+    }
+
+    bool before(ComplaintNode* a, ComplaintNode* b) {
+        if (a->priorityKey != b->priorityKey) return a->priorityKey < b->priorityKey;
+        return a->data.id < b->data.id;
+    }
+
+    void placeInHeap(ComplaintNode* node, int index) {
+        heap[index] = node;
+        node->heapIndex = index;
+    }
+
+    void siftUp(int index) {
+        ComplaintNode* node = heap[index];
+        while (index > 0) {
+            int parent = (index - 1) / HEAP_ARITY;
+            if (!before(node, heap[parent])) break;
+            placeInHeap(heap[parent], index);
+            index = parent;
+        }
+        placeInHeap(node, index);
+    }
+
+    void siftDown(int index) {
+        int size = open.getSize();
+        ComplaintNode* node = heap[index];
+        while (true) {
+            int firstChild = index * HEAP_ARITY + 1;
+            if (firstChild >= size) break;
+            int best = firstChild;
+            int lastChild = firstChild + HEAP_ARITY < size ? firstChild + HEAP_ARITY : size;
+            for (int c = firstChild + 1; c < lastChild; c++) {
+                if (before(heap[c], heap[best])) best = c;
+            }
+            if (!before(heap[best], node)) break;
+            placeInHeap(heap[best], index);
+            index = best;
+        }
+        placeInHeap(node, index);
+    }
+
+    void heapPush(ComplaintNode* node) {
+        int size = open.getSize();
+        if (size > heapCapacity) {
+            int newCapacity = heapCapacity * 2;
+            while (newCapacity < size) newCapacity *= 2;
+            ComplaintNode** newHeap = new ComplaintNode * [newCapacity];
+            for (int i = 0; i < size - 1; i++) {
+                newHeap[i] = heap[i];
+            }
+            delete[] heap;
+            heap = newHeap;
+            heapCapacity = newCapacity;
+        }
+        placeInHeap(node, size - 1);
+        siftUp(size - 1);
+    }
+
+    // Called after the node left the list, so heap[size] is the old last slot
+    void heapRemove(ComplaintNode* node) {
+        int index = node->heapIndex;
+        int last = open.getSize();
+        node->heapIndex = -1;
+        if (index == last) return;
+
+        placeInHeap(heap[last], index);
+        if (index > 0 && before(heap[index], heap[(index - 1) / HEAP_ARITY])) {
+            siftUp(index);
+        }
+        else {
+            siftDown(index);
+        }
+    }
+
+    void indexByID(ComplaintNode* node) {
+        int id = node->data.id;
+        if (id >= byIDCapacity) {
+            int newCapacity = byIDCapacity * 2;
+            while (newCapacity <= id) newCapacity *= 2;
+            ComplaintNode** newIndex = new ComplaintNode * [newCapacity]();
+            for (int i = 0; i < byIDCapacity; i++) {
+                newIndex[i] = byID[i];
+            }
+            delete[] byID;
+            byID = newIndex;
+            byIDCapacity = newCapacity;
+        }
+        byID[id] = node;
+    }
+
+    ComplaintNode* findByID(int id) {
+        return (id > 0 && id < byIDCapacity) ? byID[id] : nullptr;
+    }
+
+    void compactTimeline() {
+        int kept = 0;
+        for (int i = 0; i < timelineCount; i++) {
+            if (byID[timeline[i].id]) timeline[kept++] = timeline[i];
+        }
+        timelineCount = kept;
+        timelineDead = 0;
+    }
+
+    void addToTimeline(long long time, int id) {
+        if (timelineCount == timelineCapacity) {
+            TimelineEntry* newTimeline = new TimelineEntry[timelineCapacity * 2];
+            for (int i = 0; i < timelineCount; i++) {
+                newTimeline[i] = timeline[i];
+            }
+            delete[] timeline;
+            timeline = newTimeline;
+            timelineCapacity *= 2;
+        }
+        // Stamps from the clock arrive in order; anything older is shifted into place
+        int at = timelineCount++;
+        while (at > 0 && timeline[at - 1].time > time) {
+            timeline[at] = timeline[at - 1];
+            at--;
+        }
+        timeline[at] = { time, id };
+    }
+
+    // First timeline position filed at or after time
+    int timelineLowerBound(long long time) {
+        int lo = 0, hi = timelineCount;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (timeline[mid].time < time) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Unlinks the node from the list, the heap and all indexes; the caller recycles it
+    void unlinkNode(ComplaintNode* node) {
+        changes++;
+        open.unlink(node);
+        if (priorityMode) {
+            heapRemove(node);
+        }
+        byID[node->data.id] = nullptr;
+        byBuilding.remove(node);
+        byLocation.remove(node);
+        descriptionIndex.removeDocument(node->data.id);
+        timelineDead++;
+        if (timelineDead > 32 && timelineDead * 2 > timelineCount) compactTimeline();
+    }
+
+    ComplaintNode* findDuplicate(const string& bldg, const string& room, const string& normalized) {
+        // A building that was never interned has no complaints
+        InternedString building;
+        if (!InternedString::find(bldg, building)) return nullptr;
+        for (ComplaintNode* node = byLocation.findFirst(building, room); node;
+            node = byLocation.findNext(node, building, room)) {
+            if (node->normalized == normalized) return node;
+        }
+        return nullptr;
+    }
+
+    bool hasFolded(ComplaintNode* node, const string& user) {
+        const string& names = node->foldedBy;
+        for (size_t pos = 0; pos < names.size(); ) {
+            size_t end = names.find('\n', pos);
+            if (names.compare(pos, end - pos, user) == 0) return true;
+            pos = end + 1;
+        }
+        return false;
+    }
+
+    ComplaintNode* nextNode() {
+        return priorityMode ? heap[0] : open.first();
+    }
+
+public:
+    ComplaintQueue() : nextID(1), published(nullptr), changes(0), publishedAt(0), priorityMode(false),
+        heapCapacity(16), arrivals(0), byIDCapacity(64), byBuilding(BY_BUILDING), byLocation(BY_LOCATION),
+        timelineCount(0), timelineCapacity(64), timelineDead(0) {
+        heap = new ComplaintNode * [heapCapacity];
+        byID = new ComplaintNode * [byIDCapacity]();
+        timeline = new TimelineEntry[timelineCapacity];
+    }
+
+    ~ComplaintQueue() {
+        delete[] heap;
+        delete[] byID;
+        delete[] timeline;
+        delete published;
+    }
+
+    // Returns the complaint's ID; a near-identical open complaint at the same
+    // location absorbs the new one and its ID is returned instead
+    int enqueue(const string& user, const string& bldg, const string& room, const string& desc,
+        long long time, int severity = 1) {
+        string normalized = normalizeDescription(desc);
+        ComplaintNode* duplicate = findDuplicate(bldg, room, normalized);
+        if (duplicate) {
+            changes++;
+            // The same user filing again doesn't make it a wider problem
+            if (user != duplicate->data.raisedBy && !hasFolded(duplicate, user)) {
+                duplicate->foldedBy += user;
+                duplicate->foldedBy += '\n';
+                duplicate->data.reporters++;
+            }
+            if (severity > duplicate->data.severity) {
+                escalate(duplicate->data.id, severity - duplicate->data.severity);
+            }
+            return duplicate->data.id;
+        }
+
+        changes++;
+        ComplaintNode* newNode = acquireNode();
+        Complaint& data = newNode->data;
+        data.id = nextID++;
+        data.raisedBy = user;
+        data.building = bldg;
+        data.room = room;
+        data.description = desc;
+        data.time = time;
+        data.severity = severity;
+        data.reporters = 1;
+        newNode->priorityKey = computeKey(newNode, arrivals++);
+        newNode->normalized = normalized;
+        newNode->foldedBy.clear();
+        newNode->queuedAt = steadyNanos();
+
+        open.linkBack(newNode);
+        indexByID(newNode);
+        addToTimeline(time, data.id);
+        byBuilding.insert(newNode);
+        byLocation.insert(newNode);
+        descriptionIndex.addDocument(data.id, desc);
+        if (priorityMode) {
+            heapPush(newNode);
+        }
+        return data.id;
+    }
+
+    // Moves the complaint out of its node instead of copying it
+    Complaint dequeue() {
+        if (isEmpty()) {
+            throw "Queue is empty!";
+        }
+
+        ComplaintNode* temp = nextNode();
+        unlinkNode(temp);
+        METRIC_RECORD(OP_COMPLAINT_WAIT, steadyNanos() - temp->queuedAt);
+        METRIC_COUNT(CTR_COMPLAINTS_PROCESSED);
+        Complaint data = move(temp->data);
+        recycleNode(temp);
+        return data;
+    }
+
+    // Pops up to maxCount complaints into out[]. Contents are swapped, so the
+    // strings already in the caller's buffer go back to the pool with the node;
+    // reusing one buffer across calls makes draining allocation-free.
+    int dequeueBatch(Complaint* out, int maxCount) {
+        int count = 0;
+        long long now = METRICS_ENABLED ? steadyNanos() : 0;
+        while (count < maxCount && !isEmpty()) {
+            ComplaintNode* temp = nextNode();
+            unlinkNode(temp);
+            METRIC_RECORD(OP_COMPLAINT_WAIT, now - temp->queuedAt);
+            METRIC_COUNT(CTR_COMPLAINTS_PROCESSED);
+            swap(out[count++], temp->data);
+            recycleNode(temp);
+        }
+        return count;
+    }
+
+    const Complaint& peek() {
+        if (isEmpty()) {
+            throw "Queue is empty!";
+        }
+        return nextNode()->data;
+    }
+
+    Complaint* find(int id) {
+        ComplaintNode* node = findByID(id);
+        return node ? &node->data : nullptr;
+    }
+
+    // Leave room empty to list every open complaint in the building
+    void displayByLocation(string bldg, string room) {
+        ComplaintIndex& index = room.empty() ? byBuilding : byLocation;
+        InternedString building;
+        int count = 0;
+        if (InternedString::find(bldg, building)) {
+            for (ComplaintNode* node = index.findFirst(building, room); node; node = index.findNext(node, building, room)) {
+                node->data.display();
+                count++;
+            }
+        }
+        if (count == 0) {
+            cout << "No open complaints for this location." << endl;
+        }
+    }
+
+    // Visits open complaints filed in [from, until) oldest first; returns how many
+    int forEachFiledBetween(long long from, long long until,
+        void (*visit)(const Complaint& complaint, void* context), void* context) {
+        int visited = 0;
+        for (int i = timelineLowerBound(from); i < timelineCount && timeline[i].time < until; i++) {
+            ComplaintNode* node = byID[timeline[i].id];
+            if (!node) continue;
+            visit(node->data, context);
+            visited++;
+        }
+        return visited;
+    }
+
+    // Open complaints whose description contains every word of the query
+    int displayMatching(const string& query, int maxShown) {
+        int* ids = new int[maxShown];
+        int matches = descriptionIndex.search(query, ids, maxShown);
+        for (int i = 0; i < matches && i < maxShown; i++) {
+            byID[ids[i]]->data.display();
+        }
+        delete[] ids;
+        return matches;
+    }
+
+    bool cancel(int id) {
+        ComplaintNode* node = findByID(id);
+        if (!node) return false;
+        unlinkNode(node);
+        recycleNode(node);
+        return true;
+    }
+
+    // Raises severity by the given number of levels (capped at 5)
+    bool escalate(int id, int levels = 1) {
+        ComplaintNode* node = findByID(id);
+        if (!node || levels <= 0) return false;
+
+        changes++;
+        // Compared before adding so a huge level count can't overflow
+        int newSeverity = levels >= 5 - node->data.severity ? 5 : node->data.severity + levels;
+        node->priorityKey -= (long long)(newSeverity - node->data.severity) * AGING_STEP;
+        node->data.severity = newSeverity;
+        if (priorityMode) {
+            siftUp(node->heapIndex);
+        }
+        return true;
+    }
+
+    void setPriorityMode(bool enabled) {
+        if (enabled == priorityMode) return;
+        priorityMode = enabled;
+        if (!enabled) return;
+
+        int size = open.getSize();
+        if (size > heapCapacity) {
+            delete[] heap;
+            while (heapCapacity < size) heapCapacity *= 2;
+            heap = new ComplaintNode * [heapCapacity];
+        }
+        int i = 0;
+        for (ComplaintNode* current = open.first(); current; current = current->next) {
+            placeInHeap(current, i++);
+        }
+        for (int j = (size - 2) / HEAP_ARITY; j >= 0 && size > 1; j--) {
+            siftDown(j);
+        }
+    }
+
+    bool isPriorityMode() { return priorityMode; }
+
+    void displayAll() {
+        if (isEmpty()) {
+            cout << "No pending complaints." << endl;
+            return;
+        }
+
+        cout << "=== PENDING COMPLAINTS (" << open.getSize() << ") ===" << endl;
+        ComplaintNode* current = open.first();
+        while (current) {
+            current->data.display();
+            current = current->next;
+        }
+    }
+
+    void forEachOpen(void (*visit)(const Complaint& complaint, void* context), void* context) {
+        for (ComplaintNode* current = open.first(); current; current = current->next) {
+            visit(current->data, context);
+        }
+    }
+
+    static void printVersion(ostream& out, const ReportPin& pin) {
+        const ComplaintSnapshot* snapshot = (const ComplaintSnapshot*)pin.version;
+        if (snapshot->count == 0) {
+            out << "No pending complaints." << endl;
+            return;
+        }
+
+        out << "=== PENDING COMPLAINTS (" << snapshot->count << ") ===" << endl;
+        for (int i = 0; i < snapshot->count; i++) {
+            snapshot->items[i].display(out);
+        }
+    }
+
+    bool pinVersion(ReportPin& pin) {
+        if (!versions.pin(pin)) return false;
+        if (!published || publishedAt != changes) {
+            if (published) snapshotEpochs.retire(published, releaseObject<ComplaintSnapshot>, nullptr);
+            published = new ComplaintSnapshot(open.getSize());
+            for (ComplaintNode* current = open.first(); current; current = current->next) {
+                published->items[published->count++] = current->data;
+            }
+            publishedAt = changes;
+        }
+        pin.version = published;
+        pin.print = printVersion;
+        return true;
+    }
+
+    // Arrival time of the oldest open complaint, or 0 when none are open
+    long long oldestQueuedAt() { return open.isEmpty() ? 0 : open.first()->queuedAt; }
+
+    bool isEmpty() { return open.isEmpty(); }
+    int getSize() { return open.getSize(); }
+};
+
+// ==================== COMPLAINT DISPATCH MODULE ====================
+// Parallel processing of complaints: intake is sharded by building into
+// lock-free MPSC queues, and a pool of workers drains them. Each worker
+// prefers the shards it owns (shard % workers) for locality and steals
+// from other shards when its own are empty. A shard is drained by one
+// worker at a time, claimed through an atomic flag.
+
+struct DispatchTicket {
+    Complaint data;
+    long long submittedAt;
+    atomic<DispatchTicket*> next;
+
+    DispatchTicket(Complaint c) : data(move(c)), submittedAt(0), next(nullptr) {}
+};
+
+typedef void (*ComplaintHandler)(Complaint& complaint, int worker, void* context);
+
+class ComplaintDispatcher {
+private:
+    static const int LATENCY_BUCKETS = 64; // log2 buckets of nanoseconds
+    static const int DRAIN_BATCH = 64;
+
+    struct alignas(64) Shard {
+        atomic<DispatchTicket*> tail; // producers swap themselves in here
+        DispatchTicket* head;         // only touched by the worker holding the claim
+        atomic<bool> claimed;
+    };
+
+    struct alignas(64) WorkerStats {
+        long long processed;
+        long long stolen;
+        long long latencyBuckets[LATENCY_BUCKETS];
+    };
+
+    Shard* shards;
+    int shardCount;
+    WorkerStats* stats;
+    thread* workers;
+    int workerCount;
+    ComplaintHandler handler;
+    void* context;
+    atomic<long long> pending;
+    atomic<bool> closing;
+
+    // Vyukov MPSC pop; returns nullptr when empty or when a producer is mid-push
+    DispatchTicket* popTicket(Shard& shard) {
+        DispatchTicket* head = shard.head;
+        DispatchTicket* next = head->next.load(memory_order_acquire);
+        if (!next) return nullptr;
+
+        // The old head becomes garbage; next stays behind as the new stub
+        shard.head = next;
+        delete head;
+        return next;
+    }
+
+    int drainShard(int index, int worker) {
+        Shard& shard = shards[index];
+        bool expected = false;
+        if (shard.claimed.load(memory_order_relaxed) ||
+            !shard.claimed.compare_exchange_strong(expected, true, memory_order_acquire)) {
+            return 0;
+        }
+
+        int done = 0;
+        while (done < DRAIN_BATCH) {
+            DispatchTicket* ticket = popTicket(shard);
+            if (!ticket) break;
+
+            long long waited = steadyNanos() - ticket->submittedAt;
+            int bucket = 0;
+            while (bucket < LATENCY_BUCKETS - 2 && (1LL << (bucket + 1)) <= waited) bucket++;
+            stats[worker].latencyBuckets[bucket]++;
+
+            handler(ticket->data, worker, context);
+            done++;
+        }
+        shard.claimed.store(false, memory_order_release);
+
+        if (done > 0) {
+            stats[worker].processed += done;
+            pending.fetch_sub(done, memory_order_acq_rel);
+        }
+        return done;
+    }
+
+    void workerLoop(int worker) {
+        while (true) {
+            int done = 0;
+            for (int i = worker; i < shardCount; i += workerCount) {
+                done += drainShard(i, worker);
+            }
+            if (done == 0) {
+                for (int i = 0; i < shardCount; i++) {
+                    if (i % workerCount == worker) continue;
+                    int stolen = drainShard(i, worker);
+                    stats[worker].stolen += stolen;
+                    done += stolen;
+                }
+            }
+            if (done == 0) {
+                if (closing.load(memory_order_acquire) && pending.load(memory_order_acquire) == 0) {
+                    return;
+                }
+                this_thread::yield();
+            }
+        }
+    }
+
+    long long percentile(long long* buckets, long long total, double fraction) {
+        long long target = (long long)(total * fraction);
+        long long seen = 0;
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            seen += buckets[b];
+            if (seen > target) return bucketEnd(b);
+        }
+        return 0;
+    }
+
+    // Upper bound of a log2 bucket; the last one runs to LLONG_MAX
+    static long long bucketEnd(int b) {
+        return b + 1 >= 63 ? LLONG_MAX : 1LL << (b + 1);
+    }
+
+    // More workers than a few per core only adds contention, and a runaway
+    // count would exhaust memory or threads. At least 16 are always allowed,
+    // so --bench-dispatch runs its full sweep on small machines.
+    static int clampWorkers(int requested) {
+        int cores = (int)thread::hardware_concurrency();
+        int limit = cores * 4 > 16 ? cores * 4 : 16;
+        if (requested < 1) return 1;
+        return requested > limit ? limit : requested;
+    }
+
+public:
+    ComplaintDispatcher(int workerThreads, int shardTotal = 64)
+        : shardCount(shardTotal), workers(nullptr), workerCount(clampWorkers(workerThreads)),
+        handler(nullptr), context(nullptr), pending(0), closing(false) {
+        shards = new Shard[shardCount];
+        for (int i = 0; i < shardCount; i++) {
+            DispatchTicket* stub = new DispatchTicket(Complaint(0, "", "", "", "", 0));
+            shards[i].head = stub;
+            shards[i].tail.store(stub);
+            shards[i].claimed.store(false);
+        }
+        stats = new WorkerStats[workerCount]();
+    }
+
+    ~ComplaintDispatcher() {
+        drainAndStop();
+        for (int i = 0; i < shardCount; i++) {
+            DispatchTicket* ticket = shards[i].head;
+            while (ticket) {
+                DispatchTicket* temp = ticket;
+                ticket = ticket->next.load();
+                delete temp;
+            }
+        }
+        delete[] shards;
+        delete[] stats;
+    }
+
+    void start(ComplaintHandler complaintHandler, void* handlerContext) {
+        if (workers) return;
+        handler = complaintHandler;
+        context = handlerContext;
+        workers = new thread[workerCount];
+        for (int i = 0; i < workerCount; i++) {
+            workers[i] = thread(&ComplaintDispatcher::workerLoop, this, i);
+        }
+    }
+
+    // Safe to call from any number of producer threads
+    void submit(Complaint complaint) {
+        DispatchTicket* ticket = new DispatchTicket(move(complaint));
+        Shard& shard = shards[hashString(ticket->data.building) % shardCount];
+        pending.fetch_add(1, memory_order_relaxed);
+        ticket->submittedAt = steadyNanos();
+        DispatchTicket* prev = shard.tail.exchange(ticket, memory_order_acq_rel);
+        prev->next.store(ticket, memory_order_release);
+    }
+
+    // Blocks until every submitted complaint has been handled, then joins the workers
+    void drainAndStop() {
+        if (!workers) return;
+        closing.store(true, memory_order_release);
+        for (int i = 0; i < workerCount; i++) {
+            workers[i].join();
+        }
+        delete[] workers;
+        workers = nullptr;
+    }
+
+    int getWorkerCount() { return workerCount; }
+    long long processedBy(int worker) { return stats[worker].processed; }
+    long long stolenBy(int worker) { return stats[worker].stolen; }
+
+    // Queue latency (submit -> handler start) percentiles, as log2 bucket upper bounds
+    void latencyPercentiles(long long& p50, long long& p99, long long& total) {
+        long long merged[LATENCY_BUCKETS] = { 0 };
+        total = 0;
+        for (int w = 0; w < workerCount; w++) {
+            for (int b = 0; b < LATENCY_BUCKETS; b++) {
+                merged[b] += stats[w].latencyBuckets[b];
+                total += stats[w].latencyBuckets[b];
+            }
+        }
+        p50 = percentile(merged, total, 0.50);
+        p99 = percentile(merged, total, 0.99);
+    }
+
+    void report() {
+        for (int w = 0; w < workerCount; w++) {
+            cout << "Worker " << w + 1 << ": processed " << stats[w].processed
+                << " (stolen " << stats[w].stolen << ")" << endl;
+        }
+        long long p50, p99, total;
+        latencyPercentiles(p50, p99, total);
+        cout << "Queue latency p50 <= " << p50 / 1000 << " us, p99 <= " << p99 / 1000 << " us" << endl;
+    }
+};
+
+// Simulated maintenance work: a few passes of hashing over the complaint text
+void simulatedComplaintWork(Complaint& complaint, int worker, void* context) {
+    unsigned int hash = 0;
+    for (int pass = 0; pass < 32; pass++) {
+        hash ^= hashString(complaint.description) + pass;
+    }
+    if (context && hash == 0) {
+        (*(long long*)context)++;
+    }
+    (void)worker;
+}
+
+void benchmarkDispatcher(int complaintCount, int producerCount) {
+    const int BUILDINGS = 200;
+    string* buildingNames = new string[BUILDINGS];
+    for (int b = 0; b < BUILDINGS; b++) {
+        buildingNames[b] = "Building " + to_string(b);
+    }
+
+    cout << "Dispatcher benchmark: " << complaintCount << " complaints, "
+        << producerCount << " producers, " << BUILDINGS << " buildings" << endl;
+    cout << "workers\tcomplaints/s\tp50_us\tp99_us\tstolen" << endl;
+
+    int workerCounts[] = { 1, 2, 4, 8 };
+    for (int workersUsed : workerCounts) {
+        ComplaintDispatcher dispatcher(workersUsed);
+        long long sink = 0;
+        long long startedAt = steadyNanos();
+        dispatcher.start(simulatedComplaintWork, &sink);
+
+        thread* producers = new thread[producerCount];
+        for (int p = 0; p < producerCount; p++) {
+            producers[p] = thread([&, p]() {
+                for (int i = p; i < complaintCount; i += producerCount) {
+                    dispatcher.submit(Complaint(i + 1, "load", buildingNames[i % BUILDINGS], "R" + to_string(i % 50),
+                        "Projector not working in lecture hall", campusClock.now()));
+                }
+            });
+        }
+        for (int p = 0; p < producerCount; p++) {
+            producers[p].join();
+        }
+        delete[] producers;
+        dispatcher.drainAndStop();
+        double seconds = (steadyNanos() - startedAt) / 1e9;
+
+        long long p50, p99, total, stolen = 0;
+        dispatcher.latencyPercentiles(p50, p99, total);
+        for (int w = 0; w < workersUsed; w++) {
+            stolen += dispatcher.stolenBy(w);
+        }
+        cout << workersUsed << "\t" << (long long)(total / seconds) << "\t" << p50 / 1000
+            << "\t" << p99 / 1000 << "\t" << stolen << endl;
+    }
+    delete[] buildingNames;
+}
+
+// ==================== STACK/MESSAGING MODULE ====================
+struct Message {
+    InternedString from;
+    InternedString to;
+    string text;
+    long long time; // epoch milliseconds, see CampusClock
+
+    Message() : time(0) {}
+
+    Message(string f, string t, string txt, long long tm) : from(f), to(t), text(txt), time(tm) {
+    }
+
+    void display() const {
+        cout << "[" << formatTimestamp(time) << "] " << from << " -> " << to << ": " << text << '\n';
+    }
+};
+
+// Append-only home of every message body. Mailboxes only hold message IDs,
+// so a message lives here once no matter how many stacks it appears in.
+// Messages sit in fixed-size chunks, so references never move as it grows.
+class MessageStore {
+private:
+    static const int CHUNK_SIZE = 256;
+
+    Message** chunks;
+    int chunkCapacity;
+    int count;
+    InvertedIndex textIndex;
+
+public:
+    MessageStore() : chunkCapacity(16), count(0) {
+        chunks = new Message * [chunkCapacity]();
+    }
+
+    ~MessageStore() {
+        for (int i = 0; i * CHUNK_SIZE < count; i++) {
+            delete[] chunks[i];
+        }
+        delete[] chunks;
+    }
+
+    int append(Message msg) {
+        int chunk = count / CHUNK_SIZE;
+        if (chunk == chunkCapacity) {
+            Message** newChunks = new Message * [chunkCapacity * 2]();
+            for (int i = 0; i < chunkCapacity; i++) {
+                newChunks[i] = chunks[i];
+            }
+            delete[] chunks;
+            chunks = newChunks;
+            chunkCapacity *= 2;
+        }
+        if (count % CHUNK_SIZE == 0) {
+            chunks[chunk] = new Message[CHUNK_SIZE];
+        }
+        chunks[chunk][count % CHUNK_SIZE] = move(msg);
+        textIndex.addDocument(count, chunks[chunk][count % CHUNK_SIZE].text);
+        return count++;
+    }
+
+    // The store is append-only, so every message ever sent stays searchable
+    int displayMatching(const string& query, int maxShown) {
+        int* ids = new int[maxShown];
+        int matches = textIndex.search(query, ids, maxShown);
+        for (int i = 0; i < matches && i < maxShown; i++) {
+            get(ids[i]).display();
+        }
+        delete[] ids;
+        return matches;
+    }
+
+    const Message& get(int id) {
+        return chunks[id / CHUNK_SIZE][id % CHUNK_SIZE];
+    }
+
+    // First message ID stamped at or after time (getSize() if none). Messages
+    // are appended as they are sent, so their stamps rise with their IDs.
+    int firstAtOrAfter(long long time) {
+        int lo = 0, hi = count;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (get(mid).time < time) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    int getSize() { return count; }
+};
+
+const int MAILBOX_RETENTION = 500; // messages kept per mailbox
+const int INBOX_PAGE_SIZE = 10;
+
+// Opaque position for paging through a mailbox newest-first
+class InboxCursor {
+private:
+    int before; // next page shows message IDs below this
+    friend class InboxView;
+
+public:
+    InboxCursor() : before(-1) {}
+    bool atEnd() { return before == 0; }
+};
+
+// A user's mailbox: a chunked log of message IDs in arrival order, which is
+// also ID order since the store hands IDs out increasingly. Only the newest
+// `retention` entries are kept; whole segments drop off the old end.
+class MessageStack {
+private:
+    static const int SEGMENT_SIZE = 64;
+
+    MessageStore* store;
+    int** segments;   // ring of segment pointers
+    int segmentCapacity;
+    int segmentHead;  // ring slot of the oldest live segment
+    int segmentCount;
+    int firstSegment; // absolute segment number stored at segmentHead
+    int* spareSegment;
+    long long first;  // sequence number of the oldest retained entry
+    long long total;  // entries ever pushed
+    int retention;
+    int lastReadID;   // read marker for "new messages"
+
+    int& entry(long long seq) {
+        int segment = (int)(seq / SEGMENT_SIZE) - firstSegment;
+        return segments[(segmentHead + segment) % segmentCapacity][seq % SEGMENT_SIZE];
+    }
+
+    void addSegment() {
+        if (segmentCount == segmentCapacity) {
+            int** newSegments = new int* [segmentCapacity * 2];
+            for (int i = 0; i < segmentCount; i++) {
+                newSegments[i] = segments[(segmentHead + i) % segmentCapacity];
+            }
+            delete[] segments;
+            segments = newSegments;
+            segmentCapacity *= 2;
+            segmentHead = 0;
+        }
+        int* segment = spareSegment ? spareSegment : new int[SEGMENT_SIZE];
+        spareSegment = nullptr;
+        segments[(segmentHead + segmentCount) % segmentCapacity] = segment;
+        segmentCount++;
+    }
+
+    void dropOldestSegment() {
+        delete[] spareSegment;
+        spareSegment = segments[segmentHead];
+        segmentHead = (segmentHead + 1) % segmentCapacity;
+        segmentCount--;
+        firstSegment++;
+    }
+
+public:
+    MessageStack(MessageStore* messageStore, int retentionCap = MAILBOX_RETENTION)
+        : store(messageStore), segmentCapacity(4), segmentHead(0), segmentCount(0), firstSegment(0),
+        spareSegment(nullptr), first(0), total(0), retention(retentionCap < 1 ? 1 : retentionCap), lastReadID(-1) {
+        segments = new int* [segmentCapacity];
+    }
+
+    ~MessageStack() {
+        for (int i = 0; i < segmentCount; i++) {
+            delete[] segments[(segmentHead + i) % segmentCapacity];
+        }
+        delete[] segments;
+        delete[] spareSegment;
+    }
+
+    void push(int messageID) {
+        if (total == (long long)(firstSegment + segmentCount) * SEGMENT_SIZE) {
+            addSegment();
+        }
+        entry(total++) = messageID;
+
+        if (total - first > retention) {
+            first = total - retention;
+            while (first >= (long long)(firstSegment + 1) * SEGMENT_SIZE) {
+                dropOldestSegment();
+            }
+        }
+    }
+
+    // Removes the newest entry
+    int pop() {
+        if (isEmpty()) {
+            throw "Stack is empty!";
+        }
+
+        int messageID = entry(--total);
+        if (total == (long long)(firstSegment + segmentCount - 1) * SEGMENT_SIZE && segmentCount > 1) {
+            delete[] segments[(segmentHead + segmentCount - 1) % segmentCapacity];
+            segmentCount--;
+        }
+        return messageID;
+    }
+
+    const Message& peek() {
+        if (isEmpty()) {
+            throw "Stack is empty!";
+        }
+        return store->get(entry(total - 1));
+    }
+
+    // Sequence number just past the last retained entry whose ID is below the bound
+    long long seqBelow(int bound) {
+        long long lo = first, hi = total;
+        while (lo < hi) {
+            long long mid = lo + (hi - lo) / 2;
+            if (entry(mid) < bound) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    long long firstSeq() { return first; }
+    long long endSeq() { return total; }
+    int idAt(long long seq) { return entry(seq); }
+
+    int getReadMarker() { return lastReadID; }
+    void setReadMarker(int messageID) {
+        if (messageID > lastReadID) lastReadID = messageID;
+    }
+
+    void display() {
+        if (isEmpty()) {
+            cout << "No messages." << endl;
+            return;
+        }
+        cout << "=== MESSAGES (" << getSize() << ") ===" << endl;
+        for (long long seq = total - 1; seq >= first; seq--) {
+            store->get(entry(seq)).display();
+        }
+    }
+
+    bool isEmpty() { return total == first; }
+    int getSize() { return (int)(total - first); }
+};
+
+// Message IDs picked out by an inbox walk. Reads gather IDs first and print
+// them afterwards, so the timed part is the walk and not the console.
+class MessageIDList {
+private:
+    int* ids;
+    int count;
+    int capacity;
+
+public:
+    MessageIDList() : ids(nullptr), count(0), capacity(0) {}
+
+    ~MessageIDList() {
+        delete[] ids;
+    }
+
+    void push(int id) {
+        if (count == capacity) {
+            int newCapacity = capacity ? capacity * 2 : 16;
+            int* newIDs = new int[newCapacity];
+            for (int i = 0; i < count; i++) {
+                newIDs[i] = ids[i];
+            }
+            delete[] ids;
+            ids = newIDs;
+            capacity = newCapacity;
+        }
+        ids[count++] = id;
+    }
+
+    int get(int index) const { return ids[index]; }
+    int getSize() const { return count; }
+};
+
+// What a user sees as their inbox: their own mailbox merged newest-first with
+// the broadcast channels they belong to. Nothing is copied on broadcast; the
+// merge happens lazily here, one page at a time, by comparing message IDs
+// (IDs grow with time, so the largest ID is the newest message).
+class InboxView {
+private:
+    static const int MAX_SOURCES = 5;
+
+    MessageStore* store;
+    MessageStack* personal; // also holds the user's read marker
+    InternedString owner;
+    MessageStack* sources[MAX_SOURCES];
+    int sourceCount;
+
+    // Walks messages with IDs in (floor, before) newest-first, at most limit of
+    // them, skipping duplicates and, with skipOwn, the owner's own messages.
+    // Visited IDs are added to collect when given. Returns how many were visited.
+    int walk(int before, int floor, int limit, MessageIDList* collect, int& lastID, bool skipOwn = false) {
+        long long pos[MAX_SOURCES];
+        for (int i = 0; i < sourceCount; i++) {
+            pos[i] = before < 0 ? sources[i]->endSeq() : sources[i]->seqBelow(before);
+        }
+
+        int visited = 0;
+        lastID = -1;
+        while (visited < limit) {
+            int best = -1;
+            int bestID = floor;
+            for (int i = 0; i < sourceCount; i++) {
+                if (pos[i] > sources[i]->firstSeq() && sources[i]->idAt(pos[i] - 1) > bestID) {
+                    best = i;
+                    bestID = sources[i]->idAt(pos[i] - 1);
+                }
+            }
+            if (best < 0) break;
+
+            for (int i = 0; i < sourceCount; i++) {
+                while (pos[i] > sources[i]->firstSeq() && sources[i]->idAt(pos[i] - 1) == bestID) pos[i]--;
+            }
+            if (skipOwn && store->get(bestID).from == owner) continue;
+            if (collect) collect->push(bestID);
+            lastID = bestID;
+            visited++;
+        }
+        return visited;
+    }
+
+public:
+    InboxView(MessageStore* messageStore, MessageStack* mailbox, const string& ownerName)
+        : store(messageStore), personal(mailbox), owner(ownerName), sourceCount(0) {
+        addSource(mailbox);
+    }
+
+    void addSource(MessageStack* source) {
+        if (source && sourceCount < MAX_SOURCES) {
+            sources[sourceCount++] = source;
+        }
+    }
+
+    // Gathers up to pageSize messages newest-first starting at the cursor and
+    // returns the cursor for the following page
+    InboxCursor readPage(InboxCursor cursor, int pageSize, MessageIDList& page) {
+        int lastID;
+        int newest;
+        if (cursor.before < 0 && walk(-1, -1, 1, nullptr, newest) > 0) {
+            personal->setReadMarker(newest);
+        }
+
+        walk(cursor.before, -1, pageSize, &page, lastID);
+
+        InboxCursor next;
+        int ignored;
+        next.before = (lastID > 0 && walk(lastID, -1, 1, nullptr, ignored) > 0) ? lastID : 0;
+        return next;
+    }
+
+    // New means arrived from someone else since the read marker; the owner's
+    // outgoing copies sit in the same mailbox but never count
+    int countNew() {
+        int lastID;
+        return walk(-1, personal->getReadMarker(), 1 << 30, nullptr, lastID, true);
+    }
+
+    // Gathers only messages newer than the read marker, then advances it
+    int readNew(MessageIDList& fresh) {
+        int newest, lastID;
+        if (walk(-1, personal->getReadMarker(), 1, nullptr, newest) == 0) return 0;
+        int found = walk(-1, personal->getReadMarker(), 1 << 30, &fresh, lastID, true);
+        personal->setReadMarker(newest);
+        return found;
+    }
+
+    // Gathers messages from firstID on newest-first; the read marker is left alone
+    int readFrom(int firstID, MessageIDList& found) {
+        int lastID;
+        return walk(-1, firstID - 1, 1 << 30, &found, lastID);
+    }
+
+    void print(const MessageIDList& messages) {
+        for (int i = 0; i < messages.getSize(); i++) {
+            store->get(messages.get(i)).display();
+        }
+    }
+
+    bool isEmpty() {
+        int lastID;
+        return walk(-1, -1, 1, nullptr, lastID) == 0;
+    }
+};
+
+// Channel key for a broadcast audience; "*" matches any role or department
+inline string channelKey(const string& role, const string& department) {
+    return role + "|" + department;
+}
+
+struct UserMessages {
+    string userName;
+    MessageStack* messages;
+    UserMessages* next; // for chaining
+
+    UserMessages(string name, MessageStore* store) : userName(name), messages(new MessageStack(store)), next(nullptr) {}
+    ~UserMessages() {
+        delete messages;
+    }
+};
+
+// Per-user mailboxes, hashed by username with chaining like HashTable
+class MailboxDirectory {
+private:
+    MessageStore* store;
+    int capacity; // power of two
+    int size;
+    UserMessages** table;
+    NodePool<UserMessages> pool;
+
+    int bucketOf(const string& userName) {
+        return hashString(userName) & (capacity - 1);
+    }
+
+    void resizeTable() {
+        int oldCapacity = capacity;
+        capacity *= 2;
+        UserMessages** newTable = new UserMessages * [capacity]();
+
+        for (int i = 0; i < oldCapacity; i++) {
+            UserMessages* entry = table[i];
+            while (entry) {
+                UserMessages* next = entry->next;
+                int index = bucketOf(entry->userName);
+                entry->next = newTable[index];
+                newTable[index] = entry;
+                entry = next;
+            }
+        }
+        delete[] table;
+        table = newTable;
+    }
+
+public:
+    MailboxDirectory(MessageStore* messageStore) : store(messageStore), capacity(16), size(0) {
+        table = new UserMessages * [capacity]();
+    }
+
+    // Mailboxes are released with the pool
+    ~MailboxDirectory() {
+        delete[] table;
+    }
+
+    UserMessages* find(const string& userName) {
+        UserMessages* entry = table[bucketOf(userName)];
+        while (entry) {
+            if (entry->userName == userName) return entry;
+            entry = entry->next;
+        }
+        return nullptr;
+    }
+
+    UserMessages* findOrCreate(const string& userName) {
+        UserMessages* entry = find(userName);
+        if (entry) return entry;
+
+        if ((float)size / capacity > 0.7) {
+            resizeTable();
+        }
+        int index = bucketOf(userName);
+        entry = pool.create(userName, store);
+        entry->next = table[index];
+        table[index] = entry;
+        size++;
+        return entry;
+    }
+
+    bool remove(const string& userName) {
+        int index = bucketOf(userName);
+        UserMessages* entry = table[index];
+        UserMessages* prev = nullptr;
+
+        while (entry) {
+            if (entry->userName == userName) {
+                if (prev) {
+                    prev->next = entry->next;
+                }
+                else {
+                    table[index] = entry->next;
+                }
+                pool.destroy(entry);
+                size--;
+                return true;
+            }
+            prev = entry;
+            entry = entry->next;
+        }
+        return false;
+    }
+
+    int getSize() { return size; }
+};
+
+// A two-user thread. Participants are stored in sorted order so (a, b) and
+// (b, a) share one entry; unread[i] counts messages waiting for user i.
+struct Conversation {
+    string userA;
+    string userB;
+    MessageStack* messages;
+    int unread[2];
+    Conversation* next; // for chaining
+
+    Conversation(string a, string b, MessageStore* store) : userA(a), userB(b), messages(new MessageStack(store)), next(nullptr) {
+        unread[0] = unread[1] = 0;
+    }
+    ~Conversation() {
+        delete messages;
+    }
+
+    int sideOf(const string& userName) { return userName == userA ? 0 : 1; }
+};
+
+class ConversationIndex {
+private:
+    MessageStore* store;
+    int capacity; // power of two
+    int size;
+    Conversation** table;
+    NodePool<Conversation> pool;
+
+    int bucketOf(const string& a, const string& b) {
+        return (hashString(a) * 31 + hashString(b)) & (capacity - 1);
+    }
+
+    void resizeTable() {
+        int oldCapacity = capacity;
+        capacity *= 2;
+        Conversation** newTable = new Conversation * [capacity]();
+
+        for (int i = 0; i < oldCapacity; i++) {
+            Conversation* entry = table[i];
+            while (entry) {
+                Conversation* next = entry->next;
+                int index = bucketOf(entry->userA, entry->userB);
+                entry->next = newTable[index];
+                newTable[index] = entry;
+                entry = next;
+            }
+        }
+        delete[] table;
+        table = newTable;
+    }
+
+public:
+    ConversationIndex(MessageStore* messageStore) : store(messageStore), capacity(16), size(0) {
+        table = new Conversation * [capacity]();
+    }
+
+    // Conversations are released with the pool
+    ~ConversationIndex() {
+        delete[] table;
+    }
+
+    Conversation* find(const string& user1, const string& user2) {
+        const string& a = user1 < user2 ? user1 : user2;
+        const string& b = user1 < user2 ? user2 : user1;
+        Conversation* entry = table[bucketOf(a, b)];
+        while (entry) {
+            if (entry->userA == a && entry->userB == b) return entry;
+            entry = entry->next;
+        }
+        return nullptr;
+    }
+
+    // Called from the send path for every direct message
+    void record(const string& from, const string& to, int messageID) {
+        Conversation* conversation = find(from, to);
+        if (!conversation) {
+            if ((float)size / capacity > 0.7) {
+                resizeTable();
+            }
+            const string& a = from < to ? from : to;
+            const string& b = from < to ? to : from;
+            int index = bucketOf(a, b);
+            conversation = pool.create(a, b, store);
+            conversation->next = table[index];
+            table[index] = conversation;
+            size++;
+        }
+        conversation->messages->push(messageID);
+        if (from != to) {
+            int& unread = conversation->unread[conversation->sideOf(to)];
+            if (unread < conversation->messages->getSize()) unread++;
+        }
+    }
+
+    // Drops every thread the user took part in, so an account registered
+    // later under the same name starts with none. Deletions are rare, so
+    // this walks the whole table.
+    int removeUser(const string& userName) {
+        int removed = 0;
+        for (int i = 0; i < capacity; i++) {
+            Conversation** link = &table[i];
+            while (*link) {
+                Conversation* entry = *link;
+                if (entry->userA == userName || entry->userB == userName) {
+                    *link = entry->next;
+                    pool.destroy(entry);
+                    size--;
+                    removed++;
+                }
+                else {
+                    link = &entry->next;
+                }
+            }
+        }
+        return removed;
+    }
+
+    int unreadFor(const string& userName, const string& other) {
+        Conversation* conversation = find(userName, other);
+        return conversation ? conversation->unread[conversation->sideOf(userName)] : 0;
+    }
+
+    // Prints the thread oldest-first and marks it read for userName
+    bool display(const string& userName, const string& other) {
+        Conversation* conversation = find(userName, other);
+        if (!conversation) return false;
+
+        MessageStack* log = conversation->messages;
+        cout << "=== Conversation with " << other << " (" << log->getSize() << " messages, "
+            << conversation->unread[conversation->sideOf(userName)] << " unread) ===" << endl;
+        for (long long seq = log->firstSeq(); seq < log->endSeq(); seq++) {
+            store->get(log->idAt(seq)).display();
+        }
+        conversation->unread[conversation->sideOf(userName)] = 0;
+        return true;
+    }
+};
+
+inline size_t messageHeapBytes(const Message& msg) {
+    return stringHeapBytes(msg.text);
+}
+
+// Compares the old layout (a full Message copy in both the sender's and the
+// recipient's stack) with the shared store on a synthetic workload
+void benchmarkMessageMemory(int userCount, int messageCount) {
+    MessageStore store;
+    MessageStack** stacks = new MessageStack * [userCount];
+    for (int u = 0; u < userCount; u++) {
+        stacks[u] = new MessageStack(&store);
+    }
+
+    unsigned long long seed = 42;
+    size_t duplicatedBytes = 0;
+    size_t sharedBytes = 0;
+    for (int i = 0; i < messageCount; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        int from = (int)((seed >> 33) % userCount);
+        int to = (int)((seed >> 13) % userCount);
+        string text(20 + (int)((seed >> 41) % 100), 'a' + i % 26);
+
+        int id = store.append(Message("student" + to_string(from), "student" + to_string(to), text, i + 1));
+        stacks[from]->push(id);
+        stacks[to]->push(id);
+
+        const Message& msg = store.get(id);
+        // Old: two MessageNodes, each embedding a Message copy
+        duplicatedBytes += 2 * (sizeof(Message) + sizeof(void*) + messageHeapBytes(msg));
+        // New: one stored Message plus an ID slot in each mailbox log
+        sharedBytes += sizeof(Message) + messageHeapBytes(msg) + 2 * sizeof(int);
+    }
+
+    cout << "Message memory: " << userCount << " users, " << messageCount << " messages" << endl;
+    cout << "Duplicated per-stack copies: " << duplicatedBytes / 1024 << " KB" << endl;
+    cout << "Shared store + ID stacks:    " << sharedBytes / 1024 << " KB" << endl;
+    cout << "Saved: " << (duplicatedBytes - sharedBytes) * 100 / duplicatedBytes << "%" << endl;
+
+    for (int u = 0; u < userCount; u++) {
+        delete stacks[u];
+    }
+    delete[] stacks;
+}
+
+// ==================== AUTOCOMPLETE MODULE ====================
+enum CompletionKind { COMPLETE_USER = 1, COMPLETE_BUILDING = 2, COMPLETE_ROOM = 4 };
+
+struct TSTNode {
+    char split;
+    TSTNode* lo;
+    TSTNode* eq;
+    TSTNode* hi;
+    int counts[3]; // how many users / buildings / rooms end at this node
+    int words;     // words ending in this subtree, used to prune empty branches
+
+    TSTNode(char c) : split(c), lo(nullptr), eq(nullptr), hi(nullptr), words(0) {
+        counts[0] = counts[1] = counts[2] = 0;
+    }
+};
+
+// Ternary search trie shared by usernames, building names and room IDs.
+// Room IDs can repeat across buildings, so each end node keeps a count per
+// kind rather than a flag. Completions come out in lexicographic order and
+// stop after k, so a lookup costs the prefix length plus the k results.
+class PrefixIndex {
+private:
+    TSTNode* root;
+    NodePool<TSTNode> nodes; // releases the whole trie at once
+
+    static int kindSlot(int kind) {
+        return kind == COMPLETE_USER ? 0 : (kind == COMPLETE_BUILDING ? 1 : 2);
+    }
+
+    static bool matchesMask(TSTNode* node, int kindMask) {
+        return ((kindMask & COMPLETE_USER) && node->counts[0] > 0) ||
+            ((kindMask & COMPLETE_BUILDING) && node->counts[1] > 0) ||
+            ((kindMask & COMPLETE_ROOM) && node->counts[2] > 0);
+    }
+
+    TSTNode* findNode(const string& prefix) {
+        TSTNode* node = root;
+        size_t i = 0;
+        while (node) {
+            if (prefix[i] < node->split) {
+                node = node->lo;
+            }
+            else if (prefix[i] > node->split) {
+                node = node->hi;
+            }
+            else {
+                if (++i == prefix.size()) return node;
+                node = node->eq;
+            }
+        }
+        return nullptr;
+    }
+
+    TSTNode* insert(TSTNode* node, const string& word, size_t i, int slot) {
+        if (!node) node = nodes.create(word[i]);
+
+        if (word[i] < node->split) {
+            node->lo = insert(node->lo, word, i, slot);
+        }
+        else if (word[i] > node->split) {
+            node->hi = insert(node->hi, word, i, slot);
+        }
+        else if (i + 1 < word.size()) {
+            node->eq = insert(node->eq, word, i + 1, slot);
+        }
+        else {
+            node->counts[slot]++;
+        }
+        node->words++;
+        return node;
+    }
+
+    // Returns the subtree with the word removed, freeing nodes that became empty
+    TSTNode* remove(TSTNode* node, const string& word, size_t i, int slot, bool& removed) {
+        if (!node) return nullptr;
+
+        if (word[i] < node->split) {
+            node->lo = remove(node->lo, word, i, slot, removed);
+        }
+        else if (word[i] > node->split) {
+            node->hi = remove(node->hi, word, i, slot, removed);
+        }
+        else if (i + 1 < word.size()) {
+            node->eq = remove(node->eq, word, i + 1, slot, removed);
+        }
+        else if (node->counts[slot] > 0) {
+            node->counts[slot]--;
+            removed = true;
+        }
+
+        if (removed) node->words--;
+        if (node->words == 0) {
+            nodes.destroy(node);
+            return nullptr;
+        }
+        return node;
+    }
+
+    void collect(TSTNode* node, string& path, int kindMask, string* out, int k, int& found) {
+        if (!node || node->words == 0 || found >= k) return;
+
+        collect(node->lo, path, kindMask, out, k, found);
+        if (found >= k) return;
+
+        path += node->split;
+        if (matchesMask(node, kindMask)) {
+            out[found++] = path;
+        }
+        collect(node->eq, path, kindMask, out, k, found);
+        path.erase(path.size() - 1);
+
+        collect(node->hi, path, kindMask, out, k, found);
+    }
+
+public:
+    PrefixIndex() : root(nullptr) {}
+
+    void add(const string& word, int kind) {
+        if (word.empty()) return;
+        root = insert(root, word, 0, kindSlot(kind));
+    }
+
+    bool remove(const string& word, int kind) {
+        if (word.empty()) return false;
+        bool removed = false;
+        root = remove(root, word, 0, kindSlot(kind), removed);
+        return removed;
+    }
+
+    // Fills out[] with up to k completions of prefix and returns how many
+    int complete(const string& prefix, int kindMask, string* out, int k) {
+        int found = 0;
+        if (prefix.empty()) {
+            string path;
+            collect(root, path, kindMask, out, k, found);
+            return found;
+        }
+
+        TSTNode* node = findNode(prefix);
+        if (!node) return 0;
+
+        if (matchesMask(node, kindMask)) {
+            out[found++] = prefix;
+        }
+        string path = prefix;
+        collect(node->eq, path, kindMask, out, k, found);
+        return found;
+    }
+};
+
+// ==================== SYNTHETIC WORKLOAD MODULE ====================
+// splitmix64: tiny and fast, and one seed always yields the same stream
+class SplitMix64 {
+private:
+    unsigned long long state;
+
+public:
+    SplitMix64(unsigned long long seed) : state(seed) {}
+
+    unsigned long long next() {
+        unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    int below(int n) { return (int)(next() % (unsigned long long)n); }
+
+    double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+// Draws ranks 0..n-1 with P(k) ~ 1/(k+1)^skew by inverting the continuous
+// approximation of the harmonic sum, so no n-sized table is needed.
+// skew 0 is uniform; around 1 gives a few very hot items.
+class ZipfSampler {
+private:
+    int n;
+    double skew;
+    double low, high;
+
+    double integral(double x) {
+        return skew == 1.0 ? log(x) : (pow(x, 1.0 - skew) - 1.0) / (1.0 - skew);
+    }
+
+    double inverse(double y) {
+        return skew == 1.0 ? exp(y) : pow(1.0 + y * (1.0 - skew), 1.0 / (1.0 - skew));
+    }
+
+public:
+    ZipfSampler(int count, double s) : n(count), skew(s) {
+        low = integral(0.5);
+        high = integral(n + 0.5);
+    }
+
+    int sample(SplitMix64& rng) {
+        if (skew <= 0.0) return rng.below(n);
+        int rank = (int)(inverse(low + rng.unit() * (high - low)) + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > n) rank = n;
+        return rank - 1;
+    }
+};
+
+struct WorkloadConfig {
+    unsigned long long seed;
+    int users;
+    int buildings;
+    int roomsPerBuilding;
+    int operations;
+    int pathsPerBuilding; // edges each new building attaches with
+    double roomSkew;      // Zipf skew of room popularity
+    double userSkew;      // Zipf skew of active users and message recipients
+
+    WorkloadConfig() : seed(1), users(1000), buildings(50), roomsPerBuilding(20), operations(100000),
+        pathsPerBuilding(2), roomSkew(1.0), userSkew(0.8) {}
+};
+
+typedef void (*CommandSink)(const string& line, void* context);
+
+// Emits a reproducible script of batch commands: users, a campus graph, rooms
+// and then a mixed operation stream. The sink either writes the lines out or
+// executes them against a live system.
+class WorkloadGenerator {
+private:
+    WorkloadConfig config;
+    SplitMix64 rng;
+    CommandSink sink;
+    void* context;
+
+    void emit(const string& line) { sink(line, context); }
+
+    static string userName(int i) { return "user" + to_string(i); }
+    static string password(int i) { return "pw" + to_string(i); }
+    static string buildingName(int i) { return "BLD" + to_string(i); }
+    static string roomID(int building, int room) { return "B" + to_string(building) + "-R" + to_string(room); }
+
+    // Spreads popularity ranks over the id space so hot items aren't all in building 0
+    static int scatter(int rank, int count) {
+        return (int)((rank + 1ULL) * 2654435761ULL % (unsigned long long)count);
+    }
+
+    void generateUsers() {
+        static const char* departments[] = { "CS", "EE", "ME", "BBA", "Math", "Physics", "Civil", "Chemistry" };
+        for (int i = 0; i < config.users; i++) {
+            int r = rng.below(100);
+            const char* role = r < 2 ? "admin" : (r < 15 ? "teacher" : "student");
+            emit("register " + userName(i) + " " + password(i) + " " + role + " "
+                + departments[rng.below(8)] + " " + userName(i) + "@nu.edu.pk");
+        }
+    }
+
+    // Preferential attachment: each new building links to existing ones with
+    // probability proportional to their degree, giving a few hub buildings.
+    // Distances come from random positions on a square campus.
+    void generateCampus() {
+        int count = config.buildings;
+        int m = config.pathsPerBuilding;
+        double side = 100.0 * sqrt((double)count);
+        double* x = new double[count];
+        double* y = new double[count];
+        int* endpoints = new int[2 * (long long)m * count + 1];
+        long long endpointCount = 0;
+        int* picked = new int[m > 0 ? m : 1];
+
+        for (int i = 0; i < count; i++) {
+            x[i] = rng.unit() * side;
+            y[i] = rng.unit() * side;
+            emit("add-building " + buildingName(i));
+
+            int links = i < m ? i : m;
+            int chosen = 0;
+            for (int attempt = 0; chosen < links && attempt < links * 8; attempt++) {
+                int target = endpointCount > 0 && attempt < links * 4
+                    ? endpoints[rng.next() % endpointCount] : rng.below(i);
+                bool duplicate = false;
+                for (int k = 0; k < chosen; k++) duplicate = duplicate || picked[k] == target;
+                if (duplicate) continue;
+                picked[chosen++] = target;
+
+                double dx = x[i] - x[target], dy = y[i] - y[target];
+                int distance = (int)(sqrt(dx * dx + dy * dy) + 0.5);
+                if (distance < 1) distance = 1;
+                emit("add-path " + buildingName(i) + " " + buildingName(target) + " " + to_string(distance));
+                endpoints[endpointCount++] = i;
+                endpoints[endpointCount++] = target;
+            }
+        }
+        delete[] x;
+        delete[] y;
+        delete[] endpoints;
+        delete[] picked;
+    }
+
+    void generateRooms() {
+        static const char* types[] = { "classroom", "classroom", "lab", "office" };
+        for (int b = 0; b < config.buildings; b++) {
+            for (int r = 0; r < config.roomsPerBuilding; r++) {
+                emit("add-room " + buildingName(b) + " " + roomID(b, r) + " " + to_string(1 + r / 10)
+                    + " " + types[rng.below(4)]);
+            }
+        }
+    }
+
+    void generateOperations() {
+        static const char* issues[] = {
+            "projector not working", "air conditioner leaking", "broken chair", "wifi keeps dropping",
+            "lights flickering", "whiteboard markers missing", "door lock jammed", "power socket sparking"
+        };
+        int totalRooms = config.buildings * config.roomsPerBuilding;
+        ZipfSampler hotRooms(totalRooms, config.roomSkew);
+        ZipfSampler activeUsers(config.users, config.userSkew);
+
+        for (int op = 0; op < config.operations; op++) {
+            int room = scatter(hotRooms.sample(rng), totalRooms);
+            int building = room / config.roomsPerBuilding;
+            string where = buildingName(building) + " " + roomID(building, room % config.roomsPerBuilding);
+            int roll = rng.below(100);
+
+            if (roll < 10) {
+                int user = scatter(activeUsers.sample(rng), config.users);
+                emit("logout");
+                emit("login " + userName(user) + " " + password(user));
+            }
+            else if (roll < 40) {
+                int from = 8 + rng.below(10);
+                emit("book-slots " + where + " " + to_string(1 + rng.below(5)) + " " + to_string(from)
+                    + " " + to_string(from + rng.below(3)));
+            }
+            else if (roll < 45) {
+                emit("reserve " + where);
+            }
+            else if (roll < 50) {
+                int from = 8 + rng.below(10);
+                emit("free-rooms " + buildingName(building) + " " + to_string(1 + rng.below(5)) + " "
+                    + to_string(from) + " " + to_string(from + 1));
+            }
+            else if (roll < 70) {
+                emit("complain " + where + " " + to_string(1 + rng.below(5)) + " " + issues[rng.below(8)]);
+            }
+            else if (roll < 95) {
+                int to = scatter(activeUsers.sample(rng), config.users);
+                emit("send " + userName(to) + " message " + to_string(op) + " about " + issues[rng.below(8)]);
+            }
+            else {
+                emit("new-messages");
+            }
+        }
+    }
+
+public:
+    WorkloadGenerator(const WorkloadConfig& cfg, CommandSink output, void* outputContext)
+        : config(cfg), rng(cfg.seed), sink(output), context(outputContext) {}
+
+    void run() {
+        emit("# seed=" + to_string(config.seed) + " users=" + to_string(config.users)
+            + " buildings=" + to_string(config.buildings) + " rooms/building=" + to_string(config.roomsPerBuilding)
+            + " operations=" + to_string(config.operations));
+        generateUsers();
+        generateCampus();
+        emit("login admin admin123");
+        generateRooms();
+        if (config.users > 0 && config.buildings > 0 && config.roomsPerBuilding > 0) generateOperations();
+    }
+};
+
+void writeCommandLine(const string& line, void* file) {
+    *(ofstream*)file << line << '\n';
+}
+
+// Memory of the repeated fields (user role and department, edge destination
+// and path type, room type, complaint building, message sender and recipient)
+// on a generated campus: a std::string per record versus an interned handle
+// per record plus one pooled copy of each distinct value
+void benchmarkInternMemory(const WorkloadConfig& config) {
+    static const char* roles[] = { "student", "teacher", "admin" };
+    static const char* departments[] = { "Computer Science", "Electrical Engineering", "Mechanical Engineering",
+        "Business Administration", "Mathematics", "Physics", "Civil Engineering", "Chemistry" };
+    static const char* roomTypes[] = { "classroom", "lab", "office" };
+
+    SplitMix64 rng(config.seed);
+    size_t poolBefore = StringPool::global().memoryBytes();
+    size_t copiedBytes = 0;
+    long long fields = 0;
+    InternedString handle;
+
+    auto account = [&](const string& value) {
+        copiedBytes += sizeof(string) + stringHeapBytes(value);
+        handle = InternedString(value);
+        fields++;
+    };
+
+    for (int u = 0; u < config.users; u++) {
+        int r = rng.below(100);
+        account(roles[r < 85 ? 0 : (r < 98 ? 1 : 2)]);
+        account(departments[rng.below(8)]);
+    }
+    long long edges = 2LL * config.buildings * config.pathsPerBuilding;
+    for (long long e = 0; e < edges; e++) {
+        account("BLD" + to_string(rng.below(config.buildings)));
+        account("road");
+    }
+    for (long long r = 0; r < (long long)config.buildings * config.roomsPerBuilding; r++) {
+        account(roomTypes[rng.below(3)]);
+    }
+    // Same operation mix as the workload generator: 20% complaints, 25% messages
+    for (int op = 0; op < config.operations; op++) {
+        int roll = rng.below(100);
+        if (roll >= 50 && roll < 70) {
+            account("BLD" + to_string(rng.below(config.buildings)));
+        }
+        else if (roll >= 70 && roll < 95) {
+            account("user" + to_string(rng.below(config.users)));
+            account("user" + to_string(rng.below(config.users)));
+        }
+    }
+
+    size_t poolBytes = StringPool::global().memoryBytes() - poolBefore;
+    size_t internedBytes = fields * sizeof(InternedString) + poolBytes;
+    cout << "Interning memory: " << fields << " repeated fields, " << StringPool::global().getCount()
+        << " distinct values" << endl;
+    cout << "std::string per record:  " << copiedBytes / 1024 << " KB" << endl;
+    cout << "Handles + shared pool:   " << internedBytes / 1024 << " KB (pool " << poolBytes / 1024 << " KB)" << endl;
+    cout << "Saved: " << (copiedBytes - internedBytes) * 100 / copiedBytes << "%" << endl;
+}
+
+// ==================== BATCH MODE ====================
+const int MAX_COMMAND_TOKENS = 32;
+
+// Splits a script line into whitespace-separated tokens. Double quotes group
+// words into one token ("" gives an empty one); a line starting with # is a comment.
+// starts, if given, receives each token's offset in the line.
+int tokenizeCommand(const string& line, string* tokens, int maxTokens, size_t* starts = nullptr) {
+    int count = 0;
+    size_t pos = 0;
+    while (count < maxTokens) {
+        while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r')) pos++;
+        if (pos >= line.size()) break;
+        if (count == 0 && line[pos] == '#') break;
+
+        if (starts) starts[count] = pos;
+        string token;
+        if (line[pos] == '"') {
+            pos++;
+            while (pos < line.size() && line[pos] != '"') token += line[pos++];
+            pos++;
+        }
+        else {
+            while (pos < line.size() && line[pos] != ' ' && line[pos] != '\t' && line[pos] != '\r') token += line[pos++];
+        }
+        tokens[count++] = token;
+    }
+    return count;
+}
+
+// Rejoins tokens[from..count) so trailing free text needs no quoting
+string joinTokens(const string* tokens, int from, int count) {
+    string text;
+    for (int i = from; i < count; i++) {
+        if (i > from) text += ' ';
+        text += tokens[i];
+    }
+    return text;
+}
+
+// Trailing free text exactly as typed, from token `from` to the end of the
+// line: spacing and quotes are kept and nothing past the token limit is lost.
+// A single quoted argument still comes back without its quotes.
+string restOfLine(const string& line, const size_t* starts, const string* tokens, int from, int count) {
+    size_t begin = starts[from];
+    size_t end = line.size();
+    while (end > begin && (line[end - 1] == ' ' || line[end - 1] == '\t' || line[end - 1] == '\r')) end--;
+    if (from == count - 1 && line[begin] == '"' && begin + tokens[from].size() + 2 == end) return tokens[from];
+    return line.substr(begin, end - begin);
+}
+
+bool parseNumber(const string& text, int& value) {
+    if (text.empty()) return false;
+    char* end;
+    errno = 0;
+    long parsed = strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX) return false;
+    value = (int)parsed;
+    return true;
+}
+
+// Block-buffered sink for cout while a script runs. sync() is a no-op so the
+// endl after every result line doesn't turn into a write per line.
+class BatchOutputBuffer : public streambuf {
+private:
+    static const int BUFFER_SIZE = 1 << 16;
+    char buffer[BUFFER_SIZE];
+    FILE* target;
+
+protected:
+    int overflow(int ch) override {
+        flush();
+        if (ch != EOF) {
+            *pptr() = (char)ch;
+            pbump(1);
+        }
+        return ch == EOF ? 0 : ch;
+    }
+
+    int sync() override {
+        return 0;
+    }
+
+public:
+    BatchOutputBuffer(FILE* out) : target(out) {
+        setp(buffer, buffer + BUFFER_SIZE);
+    }
+
+    ~BatchOutputBuffer() {
+        flush();
+    }
+
+    void flush() {
+        fwrite(pbase(), 1, pptr() - pbase(), target);
+        fflush(target);
+        setp(buffer, buffer + BUFFER_SIZE);
+    }
+};
+
+// State of one script run: buffered cout, the script's logged-in user and counters
+struct BatchSession {
+    BatchOutputBuffer output;
+    streambuf* previous;
+    User* currentUser;
+    string tokens[MAX_COMMAND_TOKENS];
+    size_t starts[MAX_COMMAND_TOKENS];
+    long long executed, rejected;
+    long long startedAt;
+
+    BatchSession() : output(stdout), previous(cout.rdbuf(&output)), currentUser(nullptr),
+        executed(0), rejected(0), startedAt(steadyNanos()) {}
+
+    ~BatchSession() {
+        output.flush();
+        cout.rdbuf(previous);
+    }
+};
+
+// ==================== TEXT ESCAPING ====================
+// Bytes that force CSV quoting or need a JSON escape, one lookup per byte
+const unsigned char CSV_SPECIAL = 1;
+const unsigned char JSON_SPECIAL = 2;
+
+struct EscapeTable {
+    unsigned char flags[256];
+
+    EscapeTable() {
+        for (int c = 0; c < 256; c++) flags[c] = c < 0x20 ? JSON_SPECIAL : 0;
+        flags[(unsigned char)'"'] = CSV_SPECIAL | JSON_SPECIAL;
+        flags[(unsigned char)'\\'] = JSON_SPECIAL;
+        flags[(unsigned char)','] = CSV_SPECIAL;
+        flags[(unsigned char)'\n'] |= CSV_SPECIAL;
+        flags[(unsigned char)'\r'] |= CSV_SPECIAL;
+    }
+};
+
+const EscapeTable EXPORT_ESCAPES;
+
+// Writes the JSON escape for a JSON_SPECIAL byte into out and returns its length
+inline int jsonEscape(unsigned char c, char* out) {
+    static const char HEX[] = "0123456789abcdef";
+    out[0] = '\\';
+    if (c == '"' || c == '\\') { out[1] = (char)c; return 2; }
+    if (c == '\n') { out[1] = 'n'; return 2; }
+    if (c == '\r') { out[1] = 'r'; return 2; }
+    if (c == '\t') { out[1] = 't'; return 2; }
+    out[1] = 'u';
+    out[2] = '0';
+    out[3] = '0';
+    out[4] = HEX[c >> 4];
+    out[5] = HEX[c & 15];
+    return 6;
+}
+
+// text as a quoted JSON string
+string jsonQuote(const string& text) {
+    string quoted = "\"";
+    char escaped[6];
+    for (char c : text) {
+        if (EXPORT_ESCAPES.flags[(unsigned char)c] & JSON_SPECIAL) quoted.append(escaped, jsonEscape((unsigned char)c, escaped));
+        else quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// ==================== MICROBENCHMARK MODULE ====================
+// Times one phase at a time and appends a JSON record per phase
+class BenchSuite {
+private:
+    ostream& json;
+    bool first;
+    long long startedAt;
+    long long allocationsAtStart;
+
+public:
+    BenchSuite(ostream& out, const string& label) : json(out), first(true), startedAt(0), allocationsAtStart(0) {
+        json << "{\"label\":" << jsonQuote(label) << ",\"results\":[";
+    }
+
+    ~BenchSuite() {
+        json << "\n]}" << endl;
+    }
+
+    void start() {
+        allocationsAtStart = threadAllocations;
+        startedAt = steadyNanos();
+    }
+
+    void stop(const char* structure, const char* op, int n, long long ops) {
+        long long nanos = steadyNanos() - startedAt;
+        long long allocations = threadAllocations - allocationsAtStart;
+        if (ops <= 0) ops = 1;
+
+        char allocsPerOp[32] = "null"; // not measured without the allocation hook
+        if (ALLOCATIONS_COUNTED) snprintf(allocsPerOp, sizeof(allocsPerOp), "%.2f", (double)allocations / ops);
+
+        char line[256];
+        snprintf(line, sizeof(line),
+            "%s\n  {\"structure\":\"%s\",\"op\":\"%s\",\"n\":%d,\"ns_per_op\":%.1f,\"allocs_per_op\":%s,\"ops_per_sec\":%.0f}",
+            first ? "" : ",", structure, op, n, (double)nanos / ops, allocsPerOp,
+            nanos > 0 ? ops * 1e9 / nanos : 0.0);
+        json << line << flush;
+        first = false;
+    }
+};
+
+string* makeBenchKeys(const char* prefix, int n) {
+    string* keys = new string[n];
+    for (int i = 0; i < n; i++) keys[i] = prefix + to_string(i);
+    return keys;
+}
+
+// Visits 0..n-1 in a scattered but repeatable order
+inline int benchOrder(int i, int n) {
+    return (int)((i * 2654435761ULL + 12345) % (unsigned long long)n);
+}
+
+void benchHashTable(BenchSuite& suite, int n) {
+    string* keys = makeBenchKeys("user", n);
+    HashTable* users = new HashTable();
+
+    suite.start();
+    for (int i = 0; i < n; i++) users->registerUser(keys[i], "pw", "student", "CS", "mail");
+    suite.stop("HashTable", "register", n, n);
+
+    suite.start();
+    for (int i = 0; i < n; i++) users->login(keys[benchOrder(i, n)], "pw");
+    suite.stop("HashTable", "login", n, n);
+
+    suite.start();
+    for (int i = 0; i < n; i++) users->searchUser(keys[benchOrder(i, n)]);
+    suite.stop("HashTable", "search", n, n);
+
+    suite.start();
+    delete users;
+    suite.stop("HashTable", "teardown", n, n);
+
+    delete[] keys;
+}
+
+void benchCampusGraph(BenchSuite& suite, int n) {
+    string* keys = makeBenchKeys("B", n);
+    CampusGraph* graph = new CampusGraph();
+    CampusGraph& campus = *graph;
+
+    suite.start();
+    for (int i = 0; i < n; i++) campus.addBuilding(keys[i]);
+    suite.stop("CampusGraph", "add_building", n, n);
+
+    // A ring plus one scattered chord per building
+    suite.start();
+    for (int i = 0; i < n; i++) {
+        campus.addPath(keys[i], keys[(i + 1) % n], 1 + i % 50);
+        campus.addPath(keys[i], keys[benchOrder(i, n)], 1 + i % 50);
+    }
+    suite.stop("CampusGraph", "add_path", n, 2LL * n);
+
+    // Traversals are reported per building visited
+    suite.start();
+    campus.BFS(keys[0]);
+    suite.stop("CampusGraph", "bfs", n, n);
+
+    suite.start();
+    campus.DFS(keys[0]);
+    suite.stop("CampusGraph", "dfs", n, n);
+
+    suite.start();
+    for (int i = 0; i < n; i++) campus.removePath(keys[i], keys[(i + 1) % n]);
+    suite.stop("CampusGraph", "remove_path", n, n);
+
+    suite.start();
+    delete graph;
+    suite.stop("CampusGraph", "teardown", n, n);
+
+    delete[] keys;
+}
+
+void benchAVLTree(BenchSuite& suite, int n) {
+    string* keys = makeBenchKeys("R", n);
+    AVLTree* tree = new AVLTree();
+    AVLTree& rooms = *tree;
+
+    suite.start();
+    for (int i = 0; i < n; i++) rooms.insertRoom(Room(keys[benchOrder(i, n)], 1 + i % 10, "classroom"));
+    suite.stop("AVLTree", "insert", n, n);
+
+    suite.start();
+    for (int i = 0; i < n; i++) rooms.searchRoom(keys[benchOrder(i + 1, n)]);
+    suite.stop("AVLTree", "search", n, n);
+
+    suite.start();
+    for (int i = 0; i < n; i++) rooms.reserveRoom(keys[benchOrder(i + 2, n)], "bench");
+    suite.stop("AVLTree", "reserve", n, n);
+
+    suite.start();
+    delete tree;
+    suite.stop("AVLTree", "teardown", n, n);
+
+    delete[] keys;
+}
+
+struct BenchTimeRange {
+    long long from, until;
+    long long visited;
+};
+
+void countComplaint(const Complaint&, void* context) {
+    ((BenchTimeRange*)context)->visited++;
+}
+
+void countComplaintInRange(const Complaint& complaint, void* context) {
+    BenchTimeRange* range = (BenchTimeRange*)context;
+    if (complaint.time >= range->from && complaint.time < range->until) range->visited++;
+}
+
+void benchComplaintQueue(BenchSuite& suite, int n) {
+    // Distinct rooms and words, so nothing coalesces and index chains stay short
+    string* rooms = makeBenchKeys("R", n);
+    string* descriptions = makeBenchKeys("issue", n);
+    for (int mode = 0; mode < 2; mode++) {
+        ComplaintQueue* queue = new ComplaintQueue();
+        ComplaintQueue& complaints = *queue;
+        complaints.setPriorityMode(mode == 1);
+        const char* enqueueOp = mode == 1 ? "enqueue_priority" : "enqueue_fifo";
+        const char* dequeueOp = mode == 1 ? "dequeue_priority" : "dequeue_fifo";
+
+        suite.start();
+        for (int i = 0; i < n; i++) {
+            complaints.enqueue("bench", "CS Block", rooms[i], descriptions[i], i, 1 + i % 5);
+        }
+        suite.stop("ComplaintQueue", enqueueOp, n, n);
+
+        // Complaints filed in a 64 ms window (one per ms), through the time
+        // index and by scanning every open complaint
+        if (mode == 0) {
+            const int queries = 100;
+            BenchTimeRange range = { 0, 0, 0 };
+            volatile long long visited = 0;
+            suite.start();
+            for (int q = 0; q < queries; q++) {
+                range.from = benchOrder(q, n);
+                complaints.forEachFiledBetween(range.from, range.from + 64, countComplaint, &range);
+            }
+            visited = range.visited;
+            suite.stop("ComplaintQueue", "time_range", n, queries);
+
+            suite.start();
+            for (int q = 0; q < queries; q++) {
+                range.from = benchOrder(q, n);
+                range.until = range.from + 64;
+                complaints.forEachOpen(countComplaintInRange, &range);
+            }
+            visited = range.visited;
+            suite.stop("ComplaintQueue", "time_range_scan", n, queries);
+            (void)visited;
+        }
+
+        suite.start();
+        for (int i = 0; i < n; i++) complaints.dequeue();
+        suite.stop("ComplaintQueue", dequeueOp, n, n);
+
+        // Drained nodes stay constructed for reuse, so this frees all n of them
+        suite.start();
+        delete queue;
+        suite.stop("ComplaintQueue", mode == 1 ? "teardown_priority" : "teardown_fifo", n, n);
+    }
+    delete[] rooms;
+    delete[] descriptions;
+}
+
+void benchMessageStack(BenchSuite& suite, int n) {
+    MessageStore store;
+    MessageStack mailbox(&store, n);
+
+    suite.start();
+    for (int i = 0; i < n; i++) mailbox.push(i);
+    suite.stop("MessageStack", "push", n, n);
+
+    suite.start();
+    for (int i = 0; i < n; i++) mailbox.pop();
+    suite.stop("MessageStack", "pop", n, n);
+
+    // "Messages since" lookups: one message per ms, binary search on the stamp
+    for (int i = 0; i < n; i++) store.append(Message("a", "b", "hi", i));
+    volatile int found = 0;
+    suite.start();
+    for (int i = 0; i < n; i++) found = store.firstAtOrAfter(benchOrder(i, n));
+    suite.stop("MessageStore", "time_search", n, n);
+    (void)found;
+}
+
+// Allocator alone on Edge nodes: one heap block per node freed one by one,
+// against pool slabs released in bulk
+void benchNodePool(BenchSuite& suite, int n) {
+    Edge** edges = new Edge * [n];
+
+    suite.start();
+    for (int i = 0; i < n; i++) edges[i] = new Edge("B", i);
+    suite.stop("NodePool", "heap_alloc", n, n);
+
+    suite.start();
+    for (int i = 0; i < n; i++) delete edges[i];
+    suite.stop("NodePool", "heap_teardown", n, n);
+
+    NodePool<Edge>* pool = new NodePool<Edge>();
+    suite.start();
+    for (int i = 0; i < n; i++) edges[i] = pool->create("B", i);
+    suite.stop("NodePool", "pool_alloc", n, n);
+
+    suite.start();
+    delete pool;
+    suite.stop("NodePool", "pool_teardown", n, n);
+
+    delete[] edges;
+}
+
+// The shared list template under each policy: a FIFO drained after filling,
+// then LIFO bursts of 32 (the traversal stack pattern) that fit the inline nodes
+template <typename Queue>
+void benchLinkedQueue(BenchSuite& suite, const char* op, int n) {
+    Queue* queue = new Queue();
+
+    suite.start();
+    for (int i = 0; i < n; i++) queue->pushBack(i);
+    for (int i = 0; i < n; i++) queue->popFront();
+    suite.stop("LinkedList", op, n, 2LL * n);
+
+    delete queue;
+}
+
+template <typename Stack>
+void benchLinkedStack(BenchSuite& suite, const char* op, int n) {
+    Stack* stack = new Stack();
+
+    suite.start();
+    for (int i = 0; i < n; i += 32) {
+        for (int j = 0; j < 32; j++) stack->pushFront(i + j);
+        for (int j = 0; j < 32; j++) stack->popFront();
+    }
+    suite.stop("LinkedList", op, n, 2LL * n);
+
+    delete stack;
+}
+
+void benchLinkedList(BenchSuite& suite, int n) {
+    benchLinkedQueue<LinkedQueue<int, HeapAllocator>>(suite, "heap_queue", n);
+    benchLinkedQueue<LinkedQueue<int, PoolAllocator>>(suite, "pool_queue", n);
+    benchLinkedStack<LinkedStack<int, HeapAllocator>>(suite, "heap_stack_burst", n);
+    benchLinkedStack<LinkedStack<int, PoolAllocator>>(suite, "pool_stack_burst", n);
+    benchLinkedStack<LinkedStack<int, PoolAllocator, 32>>(suite, "inline_stack_burst", n);
+}
+
+// Sessions spread over 1024 users: open, validate every token once, then one
+// sweep after the idle limit that expires them all
+void benchSessionTable(BenchSuite& suite, int n) {
+    const int userCount = 1024;
+    User** owners = new User * [userCount];
+    for (int i = 0; i < userCount; i++) owners[i] = new User("user" + to_string(i), "pw", "student", "CS", "u@x");
+    string* tokens = new string[n];
+    SessionTable* table = new SessionTable(60);
+
+    suite.start();
+    for (int i = 0; i < n; i++) tokens[i] = table->open(owners[i & (userCount - 1)], 0);
+    suite.stop("SessionTable", "open", n, n);
+
+    suite.start();
+    for (int i = 0; i < n; i++) table->validate(tokens[i], 1);
+    suite.stop("SessionTable", "validate", n, n);
+
+    suite.start();
+    table->expire(61);
+    suite.stop("SessionTable", "expire", n, n);
+
+    delete table;
+    delete[] tokens;
+    for (int i = 0; i < userCount; i++) delete owners[i];
+    delete[] owners;
+}
+
+// Runs every structure at sizes 1e2, 1e3, ... up to maxSize and prints one
+// JSON document. Structures' own console output is discarded while timing.
+void runBenchmarks(int maxSize, const string& label) {
+    streambuf* console = cout.rdbuf();
+    ostream json(console);
+    cout.rdbuf(nullptr);
+    {
+        BenchSuite suite(json, label);
+        for (long long n = 100; n <= maxSize; n *= 10) {
+            benchHashTable(suite, (int)n);
+            benchCampusGraph(suite, (int)n);
+            benchAVLTree(suite, (int)n);
+            benchComplaintQueue(suite, (int)n);
+            benchMessageStack(suite, (int)n);
+            benchNodePool(suite, (int)n);
+            benchLinkedList(suite, (int)n);
+            benchSessionTable(suite, (int)n);
+        }
+    }
+    cout.rdbuf(console);
+}
+
+// ==================== EXPORT MODULE ====================
+// Streams a structure to CSV or JSON Lines straight from its nodes, so
+// memory stays at one buffer or one window however large the export is.
+// Records are formatted into a put area that goes to the sink whenever it
+// fills:
+//   buffered - a 1 MB buffer, one fwrite per fill
+//   writev   - the same buffer, but long fields that need no escaping are
+//              not copied; they go out as their own iovec, straight from the
+//              structure's strings, in one writev per batch
+//   mmap     - the file grows a 16 MB window at a time and records are
+//              formatted directly into the mapped window
+// Strings handed to writev are only read at the next flush, so the caller
+// keeps the structure unchanged until close(). The writev and mmap sinks
+// fall back to buffered where POSIX I/O is missing.
+enum ExportFormat { EXPORT_CSV, EXPORT_JSONL };
+enum ExportSink { SINK_BUFFERED, SINK_WRITEV, SINK_MMAP };
+
+class ExportWriter {
+private:
+    static const int BUFFER_SIZE = 1 << 20;
+    static const long long WINDOW_SIZE = 16LL << 20;
+    static const size_t ZERO_COPY_MIN = 256;
+
+    ExportFormat format;
+    ExportSink sink;
+    FILE* file;
+    bool failed;
+    char* buffer;
+    char* put;
+    char* limit;
+    string* keys; // per field: separator, and the quoted name for JSON
+    int fieldCount;
+    int fieldIndex;
+    long long bytes; // handed to the file so far
+    long long records;
+
+#ifndef _WIN32
+    static const int IOV_BATCH = 64;
+    iovec vectors[IOV_BATCH];
+    int vectorCount;
+    char* segmentStart; // buffered bytes not yet in a vector
+    char* window;
+    long long windowOffset;
+
+    void closeSegment() {
+        if (put > segmentStart) {
+            vectors[vectorCount].iov_base = segmentStart;
+            vectors[vectorCount].iov_len = put - segmentStart;
+            vectorCount++;
+            segmentStart = put;
+        }
+    }
+
+    void writeVectors() {
+        int first = 0;
+        while (first < vectorCount && !failed) {
+            ssize_t written = writev(fileno(file), vectors + first, vectorCount - first);
+            if (written < 0) {
+                if (errno != EINTR) failed = true;
+                continue;
+            }
+            bytes += written;
+            while (first < vectorCount && (size_t)written >= vectors[first].iov_len) {
+                written -= vectors[first].iov_len;
+                first++;
+            }
+            if (first < vectorCount) {
+                vectors[first].iov_base = (char*)vectors[first].iov_base + written;
+                vectors[first].iov_len -= written;
+            }
+        }
+        vectorCount = 0;
+        put = segmentStart = buffer;
+    }
+
+    // Sends a field as its own vector instead of copying it
+    void reference(const char* data, size_t length) {
+        if (vectorCount >= IOV_BATCH - 2) {
+            closeSegment();
+            writeVectors();
+        }
+        closeSegment();
+        vectors[vectorCount].iov_base = (void*)data;
+        vectors[vectorCount].iov_len = length;
+        vectorCount++;
+    }
+
+    void mapWindow() {
+        int fd = fileno(file);
+        if (ftruncate(fd, windowOffset + WINDOW_SIZE) != 0) {
+            failed = true;
+            return;
+        }
+        void* mapped = mmap(nullptr, WINDOW_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, windowOffset);
+        if (mapped == MAP_FAILED) {
+            failed = true;
+            return;
+        }
+        window = (char*)mapped;
+        put = window;
+        limit = window + WINDOW_SIZE;
+    }
+
+    void unmapWindow() {
+        if (!window) return;
+        munmap(window, WINDOW_SIZE);
+        window = nullptr;
+    }
+#endif
+
+    // Hands the put area to the sink and starts a new one
+    void spill() {
+        if (failed) {
+            put = buffer;
+            limit = buffer + BUFFER_SIZE;
+            return;
+        }
+#ifndef _WIN32
+        if (sink == SINK_WRITEV) {
+            closeSegment();
+            writeVectors();
+            return;
+        }
+        if (sink == SINK_MMAP) {
+            if (window) {
+                unmapWindow();
+                windowOffset += WINDOW_SIZE;
+            }
+            mapWindow();
+            if (failed) spill();
+            return;
+        }
+#endif
+        if (fwrite(buffer, 1, put - buffer, file) != (size_t)(put - buffer)) failed = true;
+        bytes += put - buffer;
+        put = buffer;
+    }
+
+    void append(char c) {
+        if (put == limit) spill();
+        *put++ = c;
+    }
+
+    void append(const char* data, size_t length) {
+        while (length > 0) {
+            if (put == limit) spill();
+            size_t room = limit - put;
+            size_t chunk = length < room ? length : room;
+            memcpy(put, data, chunk);
+            put += chunk;
+            data += chunk;
+            length -= chunk;
+        }
+    }
+
+    // Text that needs no escaping
+    void raw(const char* data, size_t length) {
+#ifndef _WIN32
+        if (sink == SINK_WRITEV && length >= ZERO_COPY_MIN) {
+            reference(data, length);
+            return;
+        }
+#endif
+        append(data, length);
+    }
+
+    void csvText(const char* data, size_t length) {
+        const unsigned char* flags = EXPORT_ESCAPES.flags;
+        size_t i = 0;
+        while (i < length && !(flags[(unsigned char)data[i]] & CSV_SPECIAL)) i++;
+        if (i == length) {
+            raw(data, length);
+            return;
+        }
+        append('"');
+        size_t start = 0;
+        for (i = 0; i < length; i++) {
+            if (data[i] == '"') {
+                raw(data + start, i + 1 - start);
+                append('"');
+                start = i + 1;
+            }
+        }
+        raw(data + start, length - start);
+        append('"');
+    }
+
+    void jsonText(const char* data, size_t length) {
+        const unsigned char* flags = EXPORT_ESCAPES.flags;
+        append('"');
+        size_t start = 0;
+        char escaped[6];
+        for (size_t i = 0; i < length; i++) {
+            unsigned char c = (unsigned char)data[i];
+            if (!(flags[c] & JSON_SPECIAL)) continue;
+            raw(data + start, i - start);
+            start = i + 1;
+            append(escaped, jsonEscape(c, escaped));
+        }
+        raw(data + start, length - start);
+        append('"');
+    }
+
+    void nextField() {
+        const string& key = keys[fieldIndex < fieldCount ? fieldIndex : fieldCount - 1];
+        append(key.data(), key.size());
+        fieldIndex++;
+    }
+
+public:
+    ExportWriter(ExportFormat outputFormat, ExportSink outputSink) : format(outputFormat), sink(outputSink),
+        file(nullptr), failed(false), put(nullptr), limit(nullptr), keys(nullptr), fieldCount(0), fieldIndex(0),
+        bytes(0), records(0) {
+#ifdef _WIN32
+        sink = SINK_BUFFERED;
+#else
+        vectorCount = 0;
+        window = nullptr;
+        windowOffset = 0;
+#endif
+        buffer = new char[BUFFER_SIZE];
+    }
+
+    ~ExportWriter() {
+        close();
+        delete[] keys;
+        delete[] buffer;
+    }
+
+    bool open(const string& path) {
+        file = fopen(path.c_str(), "w+b");
+        if (!file) return false;
+        setvbuf(file, nullptr, _IONBF, 0);
+        put = buffer;
+        limit = buffer + BUFFER_SIZE;
+#ifndef _WIN32
+        segmentStart = buffer;
+        if (sink == SINK_MMAP) {
+            mapWindow();
+            if (failed) return false;
+        }
+#endif
+        return true;
+    }
+
+    // Writes the CSV header line; JSON Lines uses the names as keys
+    void header(const char* const* names, int count) {
+        delete[] keys;
+        keys = new string[count];
+        fieldCount = count;
+        for (int i = 0; i < count; i++) {
+            if (i > 0) keys[i] = ",";
+            if (format == EXPORT_JSONL) {
+                keys[i] += '"';
+                keys[i] += names[i];
+                keys[i] += "\":";
+            }
+        }
+        if (format == EXPORT_CSV) {
+            for (int i = 0; i < count; i++) {
+                if (i > 0) append(',');
+                csvText(names[i], strlen(names[i]));
+            }
+            append('\n');
+        }
+    }
+
+    void beginRecord() {
+        fieldIndex = 0;
+        if (format == EXPORT_JSONL) append('{');
+    }
+
+    void field(const string& text) {
+        nextField();
+        if (format == EXPORT_CSV) csvText(text.data(), text.size());
+        else jsonText(text.data(), text.size());
+    }
+
+    void field(long long number) {
+        nextField();
+        char digits[24];
+        int length = snprintf(digits, sizeof(digits), "%lld", number);
+        append(digits, length);
+    }
+
+    void field(bool flag) {
+        nextField();
+        if (flag) append("true", 4);
+        else append("false", 5);
+    }
+
+    void endRecord() {
+        if (format == EXPORT_JSONL) append('}');
+        append('\n');
+        records++;
+    }
+
+    // Flushes and closes the file; false if any write failed
+    bool close() {
+        if (!file) return !failed;
+#ifndef _WIN32
+        if (sink == SINK_MMAP) {
+            long long size = windowOffset + (window ? put - window : 0);
+            unmapWindow();
+            if (ftruncate(fileno(file), size) != 0) failed = true;
+            bytes = size;
+        }
+        else
+#endif
+        {
+            spill();
+        }
+        if (fclose(file) != 0) failed = true;
+        file = nullptr;
+        return !failed;
+    }
+
+    long long getBytes() { return bytes; }
+    long long getRecords() { return records; }
+};
+
+bool parseExportFormat(const string& text, ExportFormat& format) {
+    if (text == "csv") format = EXPORT_CSV;
+    else if (text == "jsonl") format = EXPORT_JSONL;
+    else return false;
+    return true;
+}
+
+bool parseExportSink(const string& text, ExportSink& sink) {
+    if (text == "buffered") sink = SINK_BUFFERED;
+    else if (text == "writev") sink = SINK_WRITEV;
+    else if (text == "mmap") sink = SINK_MMAP;
+    else return false;
+    return true;
+}
+
+// Record layouts, one visitor per structure. Passwords are never exported.
+const char* const USER_FIELDS[] = { "user", "role", "department", "email", "last_booked_room" };
+const char* const ROOM_FIELDS[] = { "building", "room", "floor", "type", "reserved", "reserved_by" };
+const char* const PATH_FIELDS[] = { "from", "to", "distance", "type" };
+const char* const COMPLAINT_FIELDS[] = { "id", "raised_by", "building", "room", "severity", "reporters", "time_ms", "description" };
+const char* const MESSAGE_FIELDS[] = { "id", "from", "to", "time_ms", "text" };
+
+void exportUser(const User& user, void* context) {
+    ExportWriter& out = *(ExportWriter*)context;
+    out.beginRecord();
+    out.field(user.userName);
+    out.field(user.role.str());
+    out.field(user.department.str());
+    out.field(user.email);
+    out.field(user.lastBookedRoom);
+    out.endRecord();
+}
+
+struct RoomExport {
+    ExportWriter* out;
+    const string* building;
+};
+
+void exportRoom(const Room& room, void* context) {
+    RoomExport& target = *(RoomExport*)context;
+    ExportWriter& out = *target.out;
+    out.beginRecord();
+    out.field(*target.building);
+    out.field(room.id);
+    out.field((long long)room.floor);
+    out.field(room.type.str());
+    out.field(room.reserved);
+    out.field(room.reservedBy);
+    out.endRecord();
+}
+
+void exportPath(const string& from, const Edge& edge, void* context) {
+    ExportWriter& out = *(ExportWriter*)context;
+    out.beginRecord();
+    out.field(from);
+    out.field(edge.destBuilding.str());
+    out.field((long long)edge.distance);
+    out.field(edge.pathType.str());
+    out.endRecord();
+}
+
+void exportComplaint(const Complaint& complaint, void* context) {
+    ExportWriter& out = *(ExportWriter*)context;
+    out.beginRecord();
+    out.field((long long)complaint.id);
+    out.field(complaint.raisedBy);
+    out.field(complaint.building.str());
+    out.field(complaint.room);
+    out.field((long long)complaint.severity);
+    out.field((long long)complaint.reporters);
+    out.field(complaint.time);
+    out.field(complaint.description);
+    out.endRecord();
+}
+
+void exportMessages(MessageStore& store, ExportWriter& out) {
+    for (int id = 0; id < store.getSize(); id++) {
+        const Message& message = store.get(id);
+        out.beginRecord();
+        out.field((long long)id);
+        out.field(message.from.str());
+        out.field(message.to.str());
+        out.field(message.time);
+        out.field(message.text);
+        out.endRecord();
+    }
+}
+
+// Exports every module in both formats through each sink and reports MB/s,
+// next to the text display paths written to a file. Files go to directory
+// and are removed afterwards.
+struct ExportBenchData {
+    HashTable users;
+    AVLTree rooms;
+    CampusGraph campus;
+    ComplaintQueue complaints;
+    MessageStore messages;
+};
+
+long long runExport(ExportBenchData& data, int module, ExportWriter& out) {
+    switch (module) {
+    case 0:
+        out.header(USER_FIELDS, 5);
+        data.users.forEachUser(exportUser, &out);
+        break;
+    case 1: {
+        string building = "Bench";
+        RoomExport target = { &out, &building };
+        out.header(ROOM_FIELDS, 6);
+        data.rooms.forEachRoom(exportRoom, &target);
+        break;
+    }
+    case 2:
+        out.header(PATH_FIELDS, 4);
+        data.campus.forEachPath(exportPath, &out);
+        break;
+    case 3:
+        out.header(COMPLAINT_FIELDS, 8);
+        data.complaints.forEachOpen(exportComplaint, &out);
+        break;
+    default:
+        out.header(MESSAGE_FIELDS, 5);
+        exportMessages(data.messages, out);
+    }
+    return out.getRecords();
+}
+
+void benchmarkExport(int recordCount, const string& directory) {
+    const char* modules[5] = { "users", "rooms", "map", "complaints", "messages" };
+    const char* formats[2] = { "csv", "jsonl" };
+    const char* sinks[3] = { "buffered", "writev", "mmap" };
+
+    streambuf* console = cout.rdbuf(nullptr);
+    ExportBenchData* data = new ExportBenchData();
+    unsigned long long seed = 7;
+    long long filedAt = campusClock.now() - (long long)recordCount * MILLIS_PER_SECOND; // one record a second up to now
+    for (int i = 0; i < recordCount; i++) {
+        string name = "user" + to_string(i);
+        data->users.registerUser(name, "pw", i % 10 ? "student" : "teacher", "Computer Science", name + "@nu.edu.pk");
+        data->rooms.insertRoom(Room("R" + to_string(i), i % 12, i % 3 ? "classroom" : "lab"));
+    }
+    int buildingCount = recordCount / 10 > 2 ? recordCount / 10 : 2;
+    for (int b = 0; b < buildingCount; b++) data->campus.addBuilding("Block " + to_string(b));
+    for (int i = 0; i < recordCount; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        data->campus.addPath("Block " + to_string(i % buildingCount), "Block " + to_string((int)((seed >> 33) % buildingCount)),
+            1 + (int)((seed >> 20) % 50));
+        string description = "Projector in room " + to_string(i) + " flickers, \"again\"; reported after the "
+            + to_string(i % 7 + 1) + "th lecture of the week and still not fixed";
+        data->complaints.enqueue("user" + to_string(i), "Block " + to_string(i % buildingCount), "R" + to_string(i),
+            description, filedAt + i * MILLIS_PER_SECOND, 1 + i % 5);
+        string text(200 + (int)((seed >> 41) % 200), 'a' + i % 26);
+        data->messages.append(Message("user" + to_string(i), "user" + to_string((i + 1) % recordCount), text,
+            filedAt + i * MILLIS_PER_SECOND));
+    }
+    cout.rdbuf(console);
+
+    cout << "Export: " << recordCount << " records per module into " << directory << endl;
+    cout << "module\tformat\tsink\trecords\tMB\tMB/s" << endl;
+    string path = directory + "/universe_export.tmp";
+    char line[160];
+    long long exported[5];
+
+    for (int module = 0; module < 5; module++) {
+        for (int format = 0; format < 2; format++) {
+            for (int sink = 0; sink < 3; sink++) {
+                ExportWriter out((ExportFormat)format, (ExportSink)sink);
+                if (!out.open(path)) {
+                    cerr << "Cannot open " << path << endl;
+                    delete data;
+                    return;
+                }
+                long long startedAt = steadyNanos();
+                long long records = runExport(*data, module, out);
+                exported[module] = records;
+                bool written = out.close();
+                double elapsed = (steadyNanos() - startedAt) / 1e9;
+                double megabytes = out.getBytes() / 1e6;
+                snprintf(line, sizeof(line), "%s\t%s\t%s\t%lld\t%.1f\t%.0f%s", modules[module], formats[format],
+                    sinks[sink], records, megabytes, megabytes / elapsed, written ? "" : "\t(write failed)");
+                cout << line << endl;
+            }
+        }
+    }
+
+    // The text reports the export replaces, written to the same file
+    for (int module = 0; module < 5; module++) {
+        ofstream text(path);
+        streambuf* previous = cout.rdbuf(text.rdbuf());
+        long long startedAt = steadyNanos();
+        switch (module) {
+        case 0: data->users.displayAllUsers(); break;
+        case 1: data->rooms.displayInorder(); break;
+        case 2: data->campus.displayAdjacencyList(); break;
+        case 3: data->complaints.displayAll(); break;
+        default:
+            for (int id = 0; id < data->messages.getSize(); id++) data->messages.get(id).display();
+        }
+        text.flush();
+        double elapsed = (steadyNanos() - startedAt) / 1e9;
+        cout.rdbuf(previous);
+        double megabytes = (double)text.tellp() / 1e6;
+        snprintf(line, sizeof(line), "%s\ttext\tdisplay\t%lld\t%.1f\t%.0f", modules[module], exported[module],
+            megabytes, megabytes / elapsed);
+        cout << line << endl;
+    }
+    remove(path.c_str());
+
+    cout.rdbuf(nullptr);
+    delete data;
+    cout.rdbuf(console);
+}
+
+// ==================== MAIN SYSTEM CLASS ====================
+class UniversitySystem {
+private:
+    HashTable users;
+    CampusGraph campus;
+    ComplaintQueue complaints;
+
+    struct BuildingRooms {
+        string name;
+        AVLTree* rooms;
+        BuildingRooms* next; // hash chain
+
+        BuildingRooms(string n) : name(n), rooms(new AVLTree()), next(nullptr) {}
+        ~BuildingRooms() { 
+            delete rooms; 
+        }
+    };
+
+    // Buildings' room trees hashed by building name
+    NodePool<BuildingRooms> buildingRoomsPool;
+    BuildingRooms** buildingRooms;
+    int buildingRoomsCapacity; // power of two
+    int buildingRoomsCount;
+
+    MessageStore messageStore;
+    MailboxDirectory mailboxes;
+    MailboxDirectory channels; // broadcast channels keyed by channelKey(role, department)
+    ConversationIndex conversations;
+    PrefixIndex completions; // usernames, building names and room IDs
+    SessionTable sessions;   // server logins
+    BatchSession* batch;     // set while a script runs
+    ReportPin* report;       // set while a server request that may pin a report runs
+    bool remoteRequest;      // set while a server request runs; socket clients don't get admin signup or server-side files
+    const string* commandLine; // line the running command was read from, when there is one
+    const size_t* tokenStarts; // offsets of its tokens
+    long long commandTime;   // clock reading taken when the running script command started, 0 outside one
+
+    // Records made by one script command share the reading taken when it
+    // started; interactive actions read the clock when the record is stored,
+    // after the user has finished typing it
+    long long getCurrentTime() {
+        return commandTime ? commandTime : campusClock.tick();
+    }
+
+    int buildingBucket(const string& name) {
+        return hashString(name) & (buildingRoomsCapacity - 1);
+    }
+
+    void growBuildingRooms() {
+        int oldCapacity = buildingRoomsCapacity;
+        buildingRoomsCapacity *= 2;
+        BuildingRooms** newTable = new BuildingRooms * [buildingRoomsCapacity]();
+
+        for (int i = 0; i < oldCapacity; i++) {
+            BuildingRooms* entry = buildingRooms[i];
+            while (entry) {
+                BuildingRooms* next = entry->next;
+                int index = buildingBucket(entry->name);
+                entry->next = newTable[index];
+                newTable[index] = entry;
+                entry = next;
+            }
+        }
+        delete[] buildingRooms;
+        buildingRooms = newTable;
+    }
+
+    BuildingRooms* findBuildingRooms(const string& name) {
+        BuildingRooms* current = buildingRooms[buildingBucket(name)];
+        while (current) {
+            if (current->name == name) 
+                return current;
+            current = current->next;
+        }
+        return nullptr;
+    }
+
+    // Stores a broadcast once in its channel; members see it when they read their inbox
+    void broadcast(User* sender, string role, string department, string text) {
+        if (role.empty()) role = "*";
+        if (department.empty()) department = "*";
+        string audience = (role == "*" ? string("everyone") : role + "s")
+            + (department == "*" ? string("") : " in " + department);
+
+        int messageID = messageStore.append(Message(sender->userName, "[" + audience + "]", text, getCurrentTime()));
+        channels.findOrCreate(channelKey(role, department))->messages->push(messageID);
+        mailboxes.findOrCreate(sender->userName)->messages->push(messageID);
+    }
+
+    // Add/remove paths for users, buildings and rooms. They keep the
+    // autocomplete index in step with the underlying structures.
+    bool createUser(string uname, string pwd, string role, string dept, string email) {
+        METRIC_TIMER(OP_REGISTER);
+        if (!users.registerUser(uname, pwd, role, dept, email)) return false;
+        completions.add(uname, COMPLETE_USER);
+        METRIC_COUNT(CTR_REGISTRATIONS);
+        return true;
+    }
+
+    bool removeUser(string uname) {
+        User* user = users.searchUser(uname);
+        if (!user) return false;
+        sessions.closeAll(user);
+        users.deleteUser(uname);
+        mailboxes.remove(uname);
+        conversations.removeUser(uname);
+        completions.remove(uname, COMPLETE_USER);
+        return true;
+    }
+
+    bool createBuilding(string name) {
+        if (!campus.addBuilding(name)) return false;
+        if ((float)buildingRoomsCount / buildingRoomsCapacity > 0.7) {
+            growBuildingRooms();
+        }
+        int index = buildingBucket(name);
+        BuildingRooms* newBR = buildingRoomsPool.create(name);
+        newBR->next = buildingRooms[index];
+        buildingRooms[index] = newBR;
+        buildingRoomsCount++;
+        completions.add(name, COMPLETE_BUILDING);
+        return true;
+    }
+
+    static void forgetRoomID(const Room& room, void* context) {
+        ((PrefixIndex*)context)->remove(room.id, COMPLETE_ROOM);
+    }
+
+    bool removeBuilding(string name) {
+        if (!campus.removeBuilding(name)) return false;
+        completions.remove(name, COMPLETE_BUILDING);
+
+        int index = buildingBucket(name);
+        BuildingRooms* current = buildingRooms[index];
+        BuildingRooms* prev = nullptr;
+        while (current) {
+            if (current->name == name) {
+                if (prev) {
+                    prev->next = current->next;
+                }
+                else {
+                    buildingRooms[index] = current->next;
+                }
+                current->rooms->forEachRoom(forgetRoomID, &completions);
+                snapshotEpochs.retire(current, releaseToPool<BuildingRooms>, &buildingRoomsPool);
+                buildingRoomsCount--;
+                break;
+            }
+            prev = current;
+            current = current->next;
+        }
+        return true;
+    }
+
+    bool createRoom(BuildingRooms* building, Room room) {
+        if (!building->rooms->insertRoom(room)) return false;
+        completions.add(room.id, COMPLETE_ROOM);
+        return true;
+    }
+
+    bool removeRoom(BuildingRooms* building, string roomID) {
+        if (!building->rooms->deleteRoom(roomID)) return false;
+        completions.remove(roomID, COMPLETE_ROOM);
+        return true;
+    }
+
+    InboxView inboxFor(User* user) {
+        InboxView view(&messageStore, mailboxes.findOrCreate(user->userName)->messages, user->userName);
+        string keys[4] = {
+            channelKey(user->role, user->department),
+            channelKey(user->role, "*"),
+            channelKey("*", user->department),
+            channelKey("*", "*")
+        };
+        for (const string& key : keys) {
+            UserMessages* channel = channels.find(key);
+            if (channel) view.addSource(channel->messages);
+        }
+        return view;
+    }
+
+public:
+    UniversitySystem(long long sessionIdleSeconds = SESSION_IDLE_SECONDS) : buildingRoomsCapacity(16),
+        buildingRoomsCount(0), mailboxes(&messageStore), channels(&messageStore), conversations(&messageStore),
+        sessions(sessionIdleSeconds), batch(nullptr), report(nullptr), remoteRequest(false),
+        commandLine(nullptr), tokenStarts(nullptr), commandTime(0) {
+        buildingRooms = new BuildingRooms * [buildingRoomsCapacity]();
+
+        createUser("admin", "admin123", "admin", "Administration", "admin@nu.edu.pk");
+        createUser("Abeer", "abeer123", "student", "Computer Science", "abeer@nu.edu.pk");
+        createUser("Prof. Ayesha", "pass123", "teacher", "DS", "teacher1@nu.edu.pk");
+
+        createBuilding("Main Building");
+        createBuilding("CS Block");
+        createBuilding("Library");
+        createBuilding("Hostel");
+
+        campus.addPath("Main Building", "CS Block", 5);
+        campus.addPath("Main Building", "Library", 3);
+        campus.addPath("CS Block", "Hostel", 10);
+
+        // Add rooms to buildings
+        BuildingRooms* mb = findBuildingRooms("Main Building");
+        createRoom(mb, Room("MB101", 1, "classroom"));
+        createRoom(mb, Room("MB102", 1, "classroom"));
+        createRoom(mb, Room("MB201", 2, "lab"));
+
+        BuildingRooms* sb = findBuildingRooms("CS Block");
+        createRoom(sb, Room("CS101", 1, "lab"));
+        createRoom(sb, Room("CS102", 1, "lab"));
+        createRoom(sb, Room("CS201", 2, "classroom"));
+    }
+
+    // Building room trees are released with their pool, after anything retired
+    ~UniversitySystem() {
+        snapshotEpochs.collect();
+        delete[] buildingRooms;
+        delete batch;
+    }
+
+    void run() {
+        User* currentUser = nullptr;
+        int choice;
+
+        do {
+            cout << "\n===== UNIVERSITY MANAGEMENT SYSTEM =====" << endl;
+            if (currentUser) {
+                cout << "Logged in as: " << currentUser->userName
+                    << " (" << currentUser->role << ")" << endl;
+            }
+            cout << "1. User & Authentication" << endl;
+            cout << "2. Campus Map" << endl;
+            cout << "3. Rooms & Scheduling" << endl;
+            cout << "4. Complaints" << endl;
+            cout << "5. Messaging" << endl;
+            cout << "6. Autocomplete Lookup" << endl;
+            cout << "7. Stats (admin)" << endl;
+            cout << "8. Exit" << endl;
+            cout << "Choice: ";
+            cin >> choice;
+            cin.ignore();
+
+            switch (choice) {
+            case 1:
+                userMenu(currentUser);
+                break;
+            case 2: 
+                campusMenu(); 
+                break;
+            case 3:
+                roomsMenu(currentUser); 
+                break;
+            case 4: 
+                complaintsMenu(currentUser); 
+                break;
+            case 5: 
+                messagingMenu(currentUser);
+                break;
+            case 6:
+                autocompleteLookup();
+                break;
+            case 7:
+                statsMenu(currentUser);
+                break;
+            case 8: 
+                cout << "Goodbye!" << endl; 
+                break;
+            default: 
+                cout << "Invalid choice!" << endl;
+            }
+        } while (choice != 8);
+    }
+
+    // Script runs (one command per line, see README) skip the menus and write
+    // block-buffered output. The throughput summary goes to stderr so stdout
+    // holds only the results and two replays can be diffed.
+    void beginBatch() {
+        batch = new BatchSession();
+    }
+
+    // Executes one script line; returns false once the script says exit
+    bool batchLine(const string& line) {
+        int count = tokenizeCommand(line, batch->tokens, MAX_COMMAND_TOKENS, batch->starts);
+        if (count == 0) return true;
+        if (batch->tokens[0] == "exit" || batch->tokens[0] == "quit") return false;
+        commandLine = &line;
+        tokenStarts = batch->starts;
+        try {
+            if (executeCommand(batch->tokens, count, batch->currentUser)) batch->executed++;
+            else batch->rejected++;
+        }
+        catch (const char* msg) {
+            cout << "Error: " << msg << endl;
+            batch->executed++;
+        }
+        catch (const exception& error) {
+            cout << "Error: " << error.what() << endl;
+            batch->rejected++;
+        }
+        commandLine = nullptr;
+        commandTime = 0;
+        return true;
+    }
+
+    void endBatch() {
+        double seconds = (steadyNanos() - batch->startedAt) / 1e9;
+        long long executed = batch->executed, rejected = batch->rejected;
+        delete batch;
+        batch = nullptr;
+
+        cerr << "Batch: " << executed << " commands executed, " << rejected << " rejected in "
+            << seconds << " s (" << (seconds > 0 ? (long long)(executed / seconds) : 0) << " ops/sec)" << endl;
+    }
 
-        return y;
+    void runBatch(istream& input) {
+        beginBatch();
+        string line;
+        while (getline(input, line) && batchLine(line)) {}
+        endBatch();
     }
 
-    AVLNode* insert(AVLNode* node, Room room) {
-        if (!node) return new AVLNode(room);
+    // CommandSink that feeds generated commands straight into a running batch
+    static void executeGenerated(const string& line, void* system) {
+        ((UniversitySystem*)system)->batchLine(line);
+    }
 
-        if (room < node->data) {
-            node->left = insert(node->left, room);
-        }
-        else if (room > node->data) {
-            node->right = insert(node->right, room);
+    // One server request, already tokenized. The caller holds the server's
+    // system lock and has pointed cout at the reply. The connection holds only
+    // its session token; a session that expired or whose user was deleted
+    // validates to nobody, and a login that changes the user opens a new one.
+    // Report commands pin a version into pin instead of printing when pin is
+    // given; the caller prints it after releasing the lock. line and starts,
+    // when given, are the request line and its token offsets, for commands
+    // that end in free text. Returns false for rejected commands.
+    bool executeRequest(const string* tokens, int count, string& sessionToken, ReportPin* pin = nullptr,
+        const string* line = nullptr, const size_t* starts = nullptr) {
+        snapshotEpochs.collect();
+        long long now = steadyNanos() / 1000000000LL;
+        User* sessionUser = nullptr;
+        if (!sessionToken.empty()) {
+            sessionUser = sessions.validate(sessionToken, now);
+            if (!sessionUser) {
+                sessionToken.clear();
+                cout << "Session ended, please login again." << endl;
+            }
         }
         else {
-            return node; 
+            sessions.expire(now);
         }
 
-        node->height = 1 + max(height(node->left), height(node->right));
-        int balance = balanceFactor(node);
+        // Reattaches a connection to a session opened earlier, e.g. after a reconnect
+        if (tokens[0] == "resume") {
+            if (!needsArgs(count, 1, "resume <session token>")) return false;
+            User* user = sessions.validate(tokens[1], now);
+            if (!user) {
+                cout << "Unknown or expired session!" << endl;
+                return true;
+            }
+            sessionToken = tokens[1];
+            cout << "Session resumed for " << user->userName << endl;
+            return true;
+        }
 
-        // Left Left
-        if (balance > 1 && room < node->left->data) {
-            return rotateRight(node);
+        User* currentUser = sessionUser;
+        bool accepted = true;
+        report = pin;
+        remoteRequest = true;
+        commandLine = line;
+        tokenStarts = starts;
+        try {
+            accepted = executeCommand(tokens, count, currentUser);
         }
-        // Right Right
-        if (balance < -1 && room > node->right->data) {
-            return rotateLeft(node);
+        catch (const char* msg) {
+            cout << "Error: " << msg << endl;
         }
-        // Left Right
-        if (balance > 1 && room > node->left->data) {
-            node->left = rotateLeft(node->left);
-            return rotateRight(node);
+        // Out of memory or threads: the request fails, the server keeps going
+        catch (const exception& error) {
+            cout << "Error: " << error.what() << endl;
+            accepted = false;
         }
-        // Right Left
-        if (balance < -1 && room < node->right->data) {
-            node->right = rotateRight(node->right);
-            return rotateLeft(node);
+        report = nullptr;
+        remoteRequest = false;
+        commandLine = nullptr;
+        commandTime = 0;
+
+        if (currentUser != sessionUser) {
+            if (!sessionToken.empty()) sessions.close(sessionToken);
+            sessionToken = currentUser ? sessions.open(currentUser, now) : "";
+            if (currentUser) cout << "Session: " << sessionToken << endl;
         }
-
-        return node;
+        return accepted;
     }
 
-    AVLNode* search(AVLNode* node, string roomID) {
-        if (!node || node->data.id == roomID) 
-            return node;
+private:
+    // Pins the structure for the running server request, if there is one.
+    // False means the report should be printed now.
+    template <typename Structure>
+    bool pinReport(Structure& structure) {
+        return report && !report->guard && structure.pinVersion(*report);
+    }
 
-        if (roomID < node->data.id) {
-            return search(node->left, roomID);
+    bool requireLogin(User* currentUser) {
+        if (!currentUser) {
+            cout << "Please login first!" << endl;
+            return false;
         }
-        return search(node->right, roomID);
+        return true;
     }
 
-    void inorder(AVLNode* node) {
-        if (node) {
-            inorder(node->left);
-            cout << "Room: " << node->data.id << " (Floor: " << node->data.floor << ", Type: " << node->data.type << ", Reserved: " << (node->data.reserved ? "Yes" : "No") << ")" << endl;
-            inorder(node->right);
+    // ---------- Actions shared by the menus and batch commands ----------
+
+    void autocomplete(string prefix, string kind) {
+        const int SUGGESTIONS = 10;
+        int mask = COMPLETE_USER | COMPLETE_BUILDING | COMPLETE_ROOM;
+        if (kind == "user") mask = COMPLETE_USER;
+        else if (kind == "building") mask = COMPLETE_BUILDING;
+        else if (kind == "room") mask = COMPLETE_ROOM;
+
+        string suggestions[SUGGESTIONS];
+        int found = completions.complete(prefix, mask, suggestions, SUGGESTIONS);
+        if (found == 0) {
+            cout << "No matches." << endl;
+            return;
+        }
+        for (int i = 0; i < found; i++) {
+            cout << "  " << suggestions[i] << endl;
         }
     }
 
-    void searchByType(AVLNode* node, string type, int& count) {
-        if (node) {
-            if (node->data.type == type) {
-                count++;
-                cout << "Room: " << node->data.id << " (Floor: " << node->data.floor << ")" << endl;
-            }
-            searchByType(node->left, type, count);
-            searchByType(node->right, type, count);
+    void registerUser(string uname, string pwd, string role, string dept, string email) {
+        if (createUser(uname, pwd, role, dept, email)) {
+            cout << "Registration successful!" << endl;
+        }
+        else {
+            cout << "Registration failed!" << endl;
         }
     }
 
-public:
-    AVLTree() : root(nullptr) {}
+    void loginUser(User*& currentUser, string uname, string pwd) {
+        if (currentUser) {
+            cout << "Already logged in as " << currentUser->userName << endl;
+            return;
+        }
 
-    void insertRoom(Room room) {
-        root = insert(root, room);
+        {
+            METRIC_TIMER(OP_LOGIN);
+            currentUser = users.login(uname, pwd);
+        }
+        if (currentUser) {
+            METRIC_COUNT(CTR_LOGINS);
+            cout << "Login successful! Welcome " << currentUser->userName << endl;
+        }
+        else {
+            METRIC_COUNT(CTR_FAILED_LOGINS);
+            cout << "Invalid credentials!" << endl;
+        }
     }
 
-    Room* searchRoom(string roomID) {
-        AVLNode* node = search(root, roomID);
-        return node ? &(node->data) : nullptr;
+    void logoutUser(User*& currentUser) {
+        currentUser = nullptr;
+        cout << "Logged out." << endl;
     }
 
-    bool reserveRoom(string roomID, string userName) {
-        Room* room = searchRoom(roomID);
-        if (room && !room->reserved) {
-            room->reserved = true;
-            room->reservedBy = userName;
-            return true;
+    void updateProfile(User* currentUser, string pwd, string dept, string email) {
+        if (users.updateUser(currentUser->userName, pwd, dept, email)) {
+            cout << "Profile updated successfully!" << endl;
+        }
+        else {
+            cout << "Update failed!" << endl;
         }
-        return false;
     }
 
-    bool cancelReservation(string roomID) {
-        Room* room = searchRoom(roomID);
-        if (room && room->reserved) {
-            room->reserved = false;
-            room->reservedBy = "";
-            return true;
+    void deleteUser(User*& currentUser, string uname) {
+        if (!requireAdmin(currentUser, "delete users")) return;
+        // Deleting the logged-in account ends the session rather than leaving it dangling
+        User* target = users.searchUser(uname);
+        if (removeUser(uname)) {
+            if (currentUser == target) currentUser = nullptr;
+            cout << "User deleted successfully!" << endl;
+        }
+        else {
+            cout << "User not found!" << endl;
         }
-        return false;
     }
 
-    void displayInorder() {
-        cout << "=== Rooms (Inorder) ===" << endl;
-        inorder(root);
+    void searchUser(string uname) {
+        User* user;
+        {
+            METRIC_TIMER(OP_USER_SEARCH);
+            user = users.searchUser(uname);
+        }
+        if (user) {
+            cout << "User found:" << endl;
+            cout << "Username: " << user->userName << endl;
+            cout << "Role: " << user->role << endl;
+            cout << "Department: " << user->department << endl;
+            cout << "Email: " << user->email << endl;
+            if (!user->lastBookedRoom.empty()) {
+                cout << "Last booked room: " << user->lastBookedRoom << endl;
+            }
+        }
+        else {
+            cout << "User not found!" << endl;
+        }
     }
 
-    void displayByType(string type) {
-        cout << "=== Rooms of type: " << type << " ===" << endl;
-        int count = 0;
-        searchByType(root, type, count);
-        if (count == 0) {
-            cout << "No rooms found of this type." << endl;
+    void addBuilding(string name) {
+        if (createBuilding(name)) {
+            cout << "Building added!" << endl;
         }
     }
 
-    bool isEmpty() { return root == nullptr; }
-};
-
-// ==================== QUEUE/COMPLAINTS MODULE ====================
-struct Complaint {
-    int id;
-    string raisedBy;
-    string building;
-    string room;
-    string description;
-    string time;
-
-    Complaint(int i, string user, string bldg, string rm, string desc, string t)
-        : id(i), raisedBy(user), building(bldg), room(rm), description(desc), time(t) {
+    void deleteBuilding(string name) {
+        if (removeBuilding(name)) {
+            cout << "Building and its rooms removed!" << endl;
+        }
     }
 
-    void display() {
-        cout << "Complaint #" << id << endl;
-        cout << "From: " << raisedBy << " | Building: " << building
-            << " | Room: " << room << endl;
-        cout << "Issue: " << description << endl;
-        cout << "Time: " << time << endl;
-        cout << "------------------------" << endl;
+    void addPath(string src, string dest, int distance) {
+        METRIC_TIMER(OP_PATH_ADD);
+        campus.addPath(src, dest, distance);
     }
-};
-
-struct ComplaintNode {
-    Complaint data;
-    ComplaintNode* next;
 
-    ComplaintNode(Complaint c) : data(c), next(nullptr) {}
-};
-
-class ComplaintQueue {
-private:
-    ComplaintNode* front;
-    ComplaintNode* rear;
-    int nextID;
-    int size;
+    void removePath(string src, string dest) {
+        METRIC_TIMER(OP_PATH_REMOVE);
+        campus.removePath(src, dest);
+    }
 
-public:
-    ComplaintQueue() : front(nullptr), rear(nullptr), nextID(1), size(0) {}
+    void traverseCampus(string start, bool depthFirst) {
+        METRIC_TIMER(OP_TRAVERSAL);
+        if (depthFirst) campus.DFS(start);
+        else campus.BFS(start);
+    }
 
-    ~ComplaintQueue() {
-        while (!isEmpty()) {
-            dequeue();
+    void insertRoom(BuildingRooms* building, string id, int floor, string type) {
+        if (createRoom(building, Room(id, floor, type))) {
+            cout << "Room added!" << endl;
+        }
+        else {
+            cout << "Room already exists!" << endl;
         }
     }
 
-    void enqueue(string user, string bldg, string room, string desc, string time) {
-        Complaint newComplaint(nextID++, user, bldg, room, desc, time);
-        ComplaintNode* newNode = new ComplaintNode(newComplaint);
-
-        if (isEmpty()) {
-            front = rear = newNode;
+    void searchRoom(BuildingRooms* building, string id) {
+        Room* room;
+        {
+            METRIC_TIMER(OP_ROOM_SEARCH);
+            room = building->rooms->searchRoom(id);
+        }
+        if (room) {
+            cout << "Room found:" << endl;
+            cout << "ID: " << room->id << endl;
+            cout << "Floor: " << room->floor << endl;
+            cout << "Type: " << room->type << endl;
+            cout << "Reserved: " << (room->reserved ? "Yes" : "No") << endl;
+            if (room->reserved) {
+                cout << "Reserved by: " << room->reservedBy << endl;
+            }
         }
         else {
-            rear->next = newNode;
-            rear = newNode;
+            cout << "Room not found!" << endl;
         }
-        size++;
     }
 
-    Complaint dequeue() {
-        if (isEmpty()) {
-            throw "Queue is empty!";
+    void reserveRoom(User* currentUser, BuildingRooms* building, string roomID) {
+        bool reserved;
+        {
+            METRIC_TIMER(OP_ROOM_RESERVE);
+            reserved = building->rooms->reserveRoom(roomID, currentUser->userName);
+            if (reserved) users.updateLastBookedRoom(currentUser->userName, roomID);
         }
+        if (reserved) {
+            METRIC_COUNT(CTR_RESERVATIONS);
+            cout << "Room reserved successfully!" << endl;
+        }
+        else {
+            METRIC_COUNT(CTR_FAILED_RESERVATIONS);
+            cout << "Reservation failed! Room might be already reserved or not found." << endl;
+        }
+    }
 
-        ComplaintNode* temp = front;
-        Complaint data = temp->data;
-        front = front->next;
-
-        if (!front) rear = nullptr;
-
-        delete temp;
-        size--;
-        return data;
+    void cancelReservation(BuildingRooms* building, string roomID) {
+        if (building->rooms->cancelReservation(roomID)) {
+            cout << "Reservation cancelled!" << endl;
+        }
+        else {
+            cout << "Cancellation failed! Room might not be reserved." << endl;
+        }
     }
 
-    Complaint peek() {
-        if (isEmpty()) {
-            throw "Queue is empty!";
+    void deleteRoom(BuildingRooms* building, string roomID) {
+        if (removeRoom(building, roomID)) {
+            cout << "Room deleted!" << endl;
+        }
+        else {
+            cout << "Room not found!" << endl;
         }
-        return front->data;
     }
 
-    void displayAll() {
-        if (isEmpty()) {
-            cout << "No pending complaints." << endl;
-            return;
+    // day is 1 (Mon) to 7 (Sun) as entered by users
+    void bookSlots(User* currentUser, BuildingRooms* building, string roomID, int day, int fromHour, int toHour) {
+        bool booked;
+        {
+            METRIC_TIMER(OP_SLOT_BOOKING);
+            booked = building->rooms->reserveSlots(roomID, day - 1, fromHour, toHour, currentUser->userName);
+        }
+        if (booked) {
+            METRIC_COUNT(CTR_SLOT_BOOKINGS);
+            cout << "Slots booked!" << endl;
+        }
+        else {
+            METRIC_COUNT(CTR_FAILED_SLOT_BOOKINGS);
+            cout << "Booking failed! Room not found, invalid range or slots taken." << endl;
         }
+    }
 
-        cout << "=== PENDING COMPLAINTS (" << size << ") ===" << endl;
-        ComplaintNode* current = front;
-        while (current) {
-            current->data.display();
-            current = current->next;
+    // Admins may free anyone's slots; everyone else only their own
+    void cancelSlots(User* currentUser, BuildingRooms* building, string roomID, int day, int fromHour, int toHour) {
+        if (building->rooms->cancelSlots(roomID, day - 1, fromHour, toHour,
+            currentUser->userName, currentUser->role == ROLE_ADMIN)) {
+            cout << "Slots cancelled!" << endl;
+        }
+        else {
+            cout << "Cancellation failed! Room not found, invalid range or slots not booked by you." << endl;
         }
     }
 
-    bool isEmpty() { return front == nullptr; }
-    int getSize() { return size; }
-};
+    // day is 1 (Mon) to 7 (Sun) as entered by users
+    void findFreeRooms(BuildingRooms* building, int day, int fromHour, int toHour) {
+        METRIC_TIMER(OP_FREE_ROOM_SEARCH);
+        building->rooms->displayFreeRooms(day - 1, fromHour, toHour);
+    }
 
-// ==================== STACK/MESSAGING MODULE ====================
-struct Message {
-    string from;
-    string to;
-    string text;
-    string time;
+    void submitComplaint(User* currentUser, string bldg, string room, string desc, int severity) {
+        // Complaints intern their building, so only names on the map are taken
+        if (!buildingArg(bldg)) return;
+        if (severity < 1) severity = 1;
+        if (severity > 5) severity = 5;
+        int id;
+        int openBefore = complaints.getSize(); // a merge leaves the count unchanged
+        {
+            METRIC_TIMER(OP_COMPLAINT_SUBMIT);
+            id = complaints.enqueue(currentUser->userName, bldg, room, desc, getCurrentTime(), severity);
+        }
+        Complaint* stored = complaints.find(id);
+        METRIC_COUNT(CTR_COMPLAINTS_SUBMITTED);
+        if (complaints.getSize() == openBefore) {
+            METRIC_COUNT(CTR_COMPLAINTS_MERGED);
+            cout << "Same issue already reported - merged into complaint #" << id
+                << " (" << stored->reporters << " reporters)" << endl;
+        }
+        else {
+            cout << "Complaint #" << id << " submitted!" << endl;
+        }
+    }
 
-    Message(string f, string t, string txt, string tm) : from(f), to(t), text(txt), time(tm) {
+    void processComplaint() {
+        Complaint c;
+        {
+            METRIC_TIMER(OP_COMPLAINT_PROCESS);
+            c = complaints.dequeue();
+        }
+        cout << "Processing complaint:" << endl;
+        c.display();
     }
 
-    void display() {
-        cout << "[" << time << "] " << from << " -> " << to << ": " << text << endl;
+    void viewNextComplaint() {
+        const Complaint& c = complaints.peek();
+        cout << "Next complaint to process:" << endl;
+        c.display();
     }
-};
 
-struct MessageNode {
-    Message data;
-    MessageNode* next;
+    void escalateComplaint(int id, int levels) {
+        if (levels <= 0) {
+            cout << "Levels to raise must be at least 1!" << endl;
+        }
+        else if (complaints.escalate(id, levels)) {
+            cout << "Complaint escalated!" << endl;
+        }
+        else {
+            cout << "Complaint not found!" << endl;
+        }
+    }
 
-    MessageNode(Message m) : data(m), next(nullptr) {}
-};
+    void cancelComplaint(int id) {
+        if (complaints.cancel(id)) {
+            cout << "Complaint cancelled!" << endl;
+        }
+        else {
+            cout << "Complaint not found!" << endl;
+        }
+    }
 
-class MessageStack {
-private:
-    MessageNode* top;
-    int size;
+    void togglePriorityMode() {
+        complaints.setPriorityMode(!complaints.isPriorityMode());
+        cout << "Mode switched to " << (complaints.isPriorityMode() ? "Priority" : "FIFO") << endl;
+    }
 
-public:
-    MessageStack() : top(nullptr), size(0) {}
+    void dispatchBacklog(int workerThreads) {
+        int backlog = complaints.getSize();
+        ComplaintDispatcher dispatcher(workerThreads);
+        dispatcher.start(simulatedComplaintWork, nullptr);
+        while (!complaints.isEmpty()) {
+            dispatcher.submit(complaints.dequeue());
+        }
+        dispatcher.drainAndStop();
+        cout << "Dispatched " << backlog << " complaints:" << endl;
+        dispatcher.report();
+    }
 
-    ~MessageStack() {
-        while (!isEmpty()) {
-            pop();
+    void findComplaint(int id) {
+        Complaint* c = complaints.find(id);
+        if (c) {
+            c->display();
+        }
+        else {
+            cout << "Complaint not found!" << endl;
         }
     }
 
-    void push(Message msg) {
-        MessageNode* newNode = new MessageNode(msg);
-        newNode->next = top;
-        top = newNode;
-        size++;
+    static void printComplaint(const Complaint& complaint, void*) {
+        complaint.display();
     }
 
-    Message pop() {
-        if (isEmpty()) {
-            throw "Stack is empty!";
+    // Open complaints filed in [from, until), oldest first
+    void showComplaintsBetween(long long from, long long until) {
+        cout << "=== COMPLAINTS FILED SINCE " << formatTimestamp(from) << " ===" << endl;
+        int count = complaints.forEachFiledBetween(from, until, printComplaint, nullptr);
+        if (count == 0) {
+            cout << "No open complaints in that time range." << endl;
+        }
+        else {
+            cout << count << " open complaint(s)" << endl;
         }
-
-        MessageNode* temp = top;
-        Message data = temp->data;
-        top = top->next;
-        delete temp;
-        size--;
-        return data;
     }
 
-    Message peek() {
-        if (isEmpty()) {
-            throw "Stack is empty!";
+    void processComplaints(int n) {
+        if (n <= 0) {
+            cout << "Invalid count!" << endl;
+            return;
         }
-        return top->data;
+        // Never more than are open, so a huge count can't size the buffer
+        if (n > complaints.getSize()) n = complaints.getSize();
+        Complaint* batch = new Complaint[n > 0 ? n : 1];
+        int count;
+        {
+            METRIC_TIMER(OP_COMPLAINT_PROCESS);
+            count = complaints.dequeueBatch(batch, n);
+        }
+        cout << "Processing " << count << " complaints:" << endl;
+        for (int i = 0; i < count; i++) {
+            batch[i].display();
+        }
+        delete[] batch;
     }
 
-    void display() {
-        if (isEmpty()) {
-            cout << "No messages." << endl;
+    void searchComplaints(string query) {
+        int matches = complaints.displayMatching(query, SEARCH_RESULTS_SHOWN);
+        cout << matches << " matching complaint(s)" << endl;
+    }
+
+    void sendMessage(User* currentUser, string to, string text) {
+        if (!users.searchUser(to)) {
+            cout << "Recipient not found!" << endl;
             return;
         }
 
-        cout << "=== MESSAGES (" << size << ") ===" << endl;
-        MessageNode* current = top;
-        while (current) {
-            current->data.display();
-            current = current->next;
+        {
+            METRIC_TIMER(OP_MESSAGE_SEND);
+            UserMessages* senderMsgs = mailboxes.findOrCreate(currentUser->userName);
+
+            int messageID = messageStore.append(Message(currentUser->userName, to, text, getCurrentTime()));
+            senderMsgs->messages->push(messageID);
+
+            UserMessages* recipientMsgs = mailboxes.findOrCreate(to);
+            recipientMsgs->messages->push(messageID);
+            conversations.record(currentUser->userName, to, messageID);
         }
+        METRIC_COUNT(CTR_MESSAGES_SENT);
+
+        cout << "Message sent!" << endl;
     }
 
-    bool isEmpty() { return top == nullptr; }
-    int getSize() { return size; }
-};
+    // Inbox reads time the walk only; the messages are printed after the timer closes
+    InboxCursor inboxPage(InboxView& inbox, InboxCursor cursor) {
+        MessageIDList page;
+        InboxCursor next;
+        {
+            METRIC_TIMER(OP_INBOX_READ);
+            next = inbox.readPage(cursor, INBOX_PAGE_SIZE, page);
+        }
+        inbox.print(page);
+        return next;
+    }
 
-// ==================== MAIN SYSTEM CLASS ====================
-class UniversitySystem {
-private:
-    HashTable users;
-    CampusGraph campus;
-    ComplaintQueue complaints;
+    void checkNewMessages(User* currentUser) {
+        InboxView inbox = inboxFor(currentUser);
+        MessageIDList fresh;
+        int count;
+        {
+            METRIC_TIMER(OP_INBOX_READ);
+            count = inbox.readNew(fresh);
+        }
+        if (count == 0) {
+            cout << "No new messages!" << endl;
+            return;
+        }
+        cout << "New messages (" << count << "):" << endl;
+        inbox.print(fresh);
+    }
 
-    struct BuildingRooms {
-        string name;
-        AVLTree* rooms;
-        BuildingRooms* next;
+    // Inbox messages sent at or after from, newest first
+    void showMessagesSince(User* currentUser, long long from) {
+        InboxView inbox = inboxFor(currentUser);
+        MessageIDList found;
+        int count;
+        {
+            METRIC_TIMER(OP_INBOX_READ);
+            count = inbox.readFrom(messageStore.firstAtOrAfter(from), found);
+        }
+        cout << "=== MESSAGES SINCE " << formatTimestamp(from) << " ===" << endl;
+        inbox.print(found);
+        if (count == 0) {
+            cout << "No messages in that time range." << endl;
+        }
+        else {
+            cout << count << " message(s)" << endl;
+        }
+    }
 
-        BuildingRooms(string n) : name(n), rooms(new AVLTree()), next(nullptr) {}
-        ~BuildingRooms() { 
-            delete rooms; 
+    void broadcastMessage(User* currentUser, string role, string dept, string text) {
+        if (currentUser->role != ROLE_ADMIN) {
+            cout << "Only admins can broadcast!" << endl;
+            return;
         }
-    };
+        {
+            METRIC_TIMER(OP_MESSAGE_SEND);
+            broadcast(currentUser, role, dept, text);
+        }
+        METRIC_COUNT(CTR_BROADCASTS);
+        cout << "Broadcast sent!" << endl;
+    }
 
-    BuildingRooms* buildingRooms;
+    void viewConversation(User* currentUser, string other) {
+        if (!conversations.display(currentUser->userName, other)) {
+            cout << "No conversation with " << other << "!" << endl;
+        }
+    }
 
-    struct UserMessages {
-        string userName;
-        MessageStack* messages;
-        UserMessages* next;
+    void searchMessages(User* currentUser, string query) {
+        if (currentUser->role != ROLE_ADMIN) {
+            cout << "Only admins can search messages!" << endl;
+            return;
+        }
+        int matches = messageStore.displayMatching(query, SEARCH_RESULTS_SHOWN);
+        cout << matches << " matching message(s)" << endl;
+    }
 
-        UserMessages(string name) : userName(name), messages(new MessageStack()), next(nullptr) {}
-        ~UserMessages() { 
-            delete messages; 
+    bool requireAdmin(User* currentUser, const char* action = "view stats") {
+        if (!requireLogin(currentUser)) return false;
+        if (currentUser->role != ROLE_ADMIN) {
+            cout << "Only admins can " << action << "!" << endl;
+            return false;
         }
-    };
+        return true;
+    }
 
-    UserMessages* userMessages;
+    double backlogAgeSeconds() {
+        long long oldest = complaints.oldestQueuedAt();
+        return oldest ? (steadyNanos() - oldest) / 1e9 : 0.0;
+    }
 
-    string getCurrentTime() {
-        static int counter = 1;
-        string time = "Timestamp_" + to_string(counter);
-        counter++;
-        return time;
+    void showStats() {
+        cout << "=== SYSTEM STATS ===" << endl;
+        if (!METRICS_ENABLED) {
+            cout << "(metrics were compiled out of this build)" << endl;
+        }
+        cout << "Complaint backlog: " << complaints.getSize() << " (oldest waiting "
+            << backlogAgeSeconds() << " s)" << endl;
+        cout << "Open sessions: " << sessions.getCount() << " (" << sessions.getExpiredTotal()
+            << " expired after " << sessions.getIdleSeconds() << " s idle)" << endl;
+        Metrics::display();
     }
 
-    BuildingRooms* findBuildingRooms(string name) {
-        BuildingRooms* current = buildingRooms;
-        while (current) {
-            if (current->name == name) 
-                return current;
-            current = current->next;
+    void dumpStats(string path) {
+        ofstream out(path);
+        if (!out) {
+            cout << "Cannot open " << path << endl;
+            return;
         }
-        return nullptr;
+        out << "# TYPE universe_complaint_backlog gauge\n";
+        out << "universe_complaint_backlog " << complaints.getSize() << "\n";
+        out << "# TYPE universe_complaint_backlog_age_seconds gauge\n";
+        out << "universe_complaint_backlog_age_seconds " << backlogAgeSeconds() << "\n";
+        out << "# TYPE universe_open_sessions gauge\n";
+        out << "universe_open_sessions " << sessions.getCount() << "\n";
+        out << "# TYPE universe_sessions_expired_total counter\n";
+        out << "universe_sessions_expired_total " << sessions.getExpiredTotal() << "\n";
+        Metrics::writePrometheus(out);
+        cout << "Stats written to " << path << endl;
     }
 
-    UserMessages* findUserMessages(string userName) {
-        UserMessages* current = userMessages;
-        while (current) {
-            if (current->userName == userName) 
-                return current;
-            current = current->next;
+    void resetStats() {
+        Metrics::reset();
+        cout << "Stats reset." << endl;
+    }
+
+    // Streams one module to a file, see ExportWriter
+    void exportData(const string& module, ExportFormat format, ExportSink sink, const string& path) {
+        ExportWriter out(format, sink);
+        if (!out.open(path)) {
+            cout << "Cannot open " << path << endl;
+            return;
         }
-        return nullptr;
+        if (module == "users") {
+            out.header(USER_FIELDS, 5);
+            users.forEachUser(exportUser, &out);
+        }
+        else if (module == "rooms") {
+            out.header(ROOM_FIELDS, 6);
+            for (int i = 0; i < buildingRoomsCapacity; i++) {
+                for (BuildingRooms* building = buildingRooms[i]; building; building = building->next) {
+                    RoomExport target = { &out, &building->name };
+                    building->rooms->forEachRoom(exportRoom, &target);
+                }
+            }
+        }
+        else if (module == "map") {
+            out.header(PATH_FIELDS, 4);
+            campus.forEachPath(exportPath, &out);
+        }
+        else if (module == "complaints") {
+            out.header(COMPLAINT_FIELDS, 8);
+            complaints.forEachOpen(exportComplaint, &out);
+        }
+        else {
+            out.header(MESSAGE_FIELDS, 5);
+            exportMessages(messageStore, out);
+        }
+        if (!out.close()) {
+            cout << "Export to " << path << " failed!" << endl;
+            return;
+        }
+        cout << "Exported " << out.getRecords() << " " << module << " records (" << out.getBytes()
+            << " bytes) to " << path << endl;
     }
 
-public:
-    UniversitySystem() : buildingRooms(nullptr), userMessages(nullptr) {
-        users.registerUser("admin", "admin123", "admin", "Administration", "admin@nu.edu.pk");
-        users.registerUser("Abeer", "abeer123", "student", "Computer Science", "abeer@nu.edu.pk");
-        users.registerUser("Prof. Ayesha", "pass123", "teacher", "DS", "teacher1@nu.edu.pk");
+    // ---------- Batch command dispatch ----------
 
-        campus.addBuilding("Main Building");
-        campus.addBuilding("CS Block");
-        campus.addBuilding("Library");
-        campus.addBuilding("Hostel");
+    bool needsArgs(int count, int required, const char* usage) {
+        if (count > required) return true;
+        cout << "Usage: " << usage << endl;
+        return false;
+    }
 
-        campus.addPath("Main Building", "CS Block", 5);
-        campus.addPath("Main Building", "Library", 3);
-        campus.addPath("CS Block", "Hostel", 10);
+    bool numberArg(const string& text, int& value) {
+        if (parseNumber(text, value)) return true;
+        cout << "Invalid number: " << text << endl;
+        return false;
+    }
 
-        // Add rooms to buildings
-        BuildingRooms* mb = new BuildingRooms("Main Building");
-        mb->rooms->insertRoom(Room("MB101", 1, "classroom"));
-        mb->rooms->insertRoom(Room("MB102", 1, "classroom"));
-        mb->rooms->insertRoom(Room("MB201", 2, "lab"));
-        mb->next = buildingRooms;
-        buildingRooms = mb;
+    // Trailing free text (message bodies, descriptions, search words): the raw
+    // rest of the line when the command came from one, else the rejoined tokens
+    string freeText(const string* t, int n, int from) {
+        if (!commandLine) return joinTokens(t, from, n);
+        return restOfLine(*commandLine, tokenStarts, t, from, n);
+    }
 
-        BuildingRooms* sb = new BuildingRooms("CS Block");
-        sb->rooms->insertRoom(Room("CS101", 1, "lab"));
-        sb->rooms->insertRoom(Room("CS102", 1, "lab"));
-        sb->rooms->insertRoom(Room("CS201", 2, "classroom"));
-        sb->next = buildingRooms;
-        buildingRooms = sb;
+    // Commands that write files where the caller names them run only from the
+    // console or a script, never for a socket client
+    bool localOnly(const char* command) {
+        if (!remoteRequest) return true;
+        cout << command << " is not available over the server!" << endl;
+        return false;
     }
 
-    ~UniversitySystem() {
-        // Clean up building rooms
-        BuildingRooms* currentBR = buildingRooms;
-        while (currentBR) {
-            BuildingRooms* temp = currentBR;
-            currentBR = currentBR->next;
-            delete temp;
+    bool timeArg(const string& text, long long& millis) {
+        if (parseTimeArg(text, getCurrentTime(), millis)) return true;
+        cout << "Invalid time: " << text << " (use 30m, 2h, 1d, 1w, today, monday or YYYY-MM-DD [HH:MM])" << endl;
+        return false;
+    }
+
+    bool exportArgs(const string* t, int n, ExportFormat& format, ExportSink& sink) {
+        if (t[1] != "users" && t[1] != "rooms" && t[1] != "map" && t[1] != "complaints" && t[1] != "messages") {
+            cout << "Unknown export module: " << t[1] << endl;
+            return false;
+        }
+        if (!parseExportFormat(t[2], format)) {
+            cout << "Unknown export format: " << t[2] << endl;
+            return false;
+        }
+        if (n > 4 && !parseExportSink(t[4], sink)) {
+            cout << "Unknown export sink: " << t[4] << endl;
+            return false;
         }
+        return true;
+    }
 
-        // Clean up user messages
-        UserMessages* currentUM = userMessages;
-        while (currentUM) {
-            UserMessages* temp = currentUM;
-            currentUM = currentUM->next;
-            delete temp;
+    BuildingRooms* buildingArg(const string& name) {
+        BuildingRooms* building = findBuildingRooms(name);
+        if (!building) cout << "Building not found!" << endl;
+        return building;
+    }
+
+    // Runs one tokenized script command. Returns false for unknown commands
+    // and malformed arguments; an action that runs but fails still counts.
+    bool executeCommand(const string* t, int n, User*& currentUser) {
+        const string& cmd = t[0];
+        commandTime = campusClock.tick();
+        int a = 0, b = 0, c = 0;
+
+        // User & authentication
+        if (cmd == "register") {
+            if (!needsArgs(n, 5, "register <user> <password> <role> <department> <email>")) return false;
+            if (remoteRequest && t[3] == ROLE_ADMIN.str() && !(currentUser && currentUser->role == ROLE_ADMIN)) {
+                cout << "Only admins can create admin accounts!" << endl;
+                return true;
+            }
+            registerUser(t[1], t[2], t[3], t[4], t[5]);
+        }
+        else if (cmd == "login") {
+            if (!needsArgs(n, 2, "login <user> <password>")) return false;
+            loginUser(currentUser, t[1], t[2]);
+        }
+        else if (cmd == "logout") {
+            logoutUser(currentUser);
+        }
+        else if (cmd == "update-profile") {
+            if (!needsArgs(n, 3, "update-profile <password> <department> <email>")) return false;
+            if (requireLogin(currentUser)) updateProfile(currentUser, t[1], t[2], t[3]);
+        }
+        else if (cmd == "delete-user") {
+            if (!needsArgs(n, 1, "delete-user <user>")) return false;
+            deleteUser(currentUser, t[1]);
+        }
+        else if (cmd == "search-user") {
+            if (!needsArgs(n, 1, "search-user <user>")) return false;
+            searchUser(t[1]);
+        }
+        else if (cmd == "list-users") {
+            if (!pinReport(users)) users.displayAllUsers();
+        }
+        // Campus map
+        else if (cmd == "add-building") {
+            if (!needsArgs(n, 1, "add-building <name>")) return false;
+            addBuilding(t[1]);
+        }
+        else if (cmd == "remove-building") {
+            if (!needsArgs(n, 1, "remove-building <name>")) return false;
+            deleteBuilding(t[1]);
+        }
+        else if (cmd == "add-path") {
+            if (!needsArgs(n, 3, "add-path <source> <destination> <distance>") || !numberArg(t[3], a)) return false;
+            addPath(t[1], t[2], a);
+        }
+        else if (cmd == "remove-path") {
+            if (!needsArgs(n, 2, "remove-path <source> <destination>")) return false;
+            removePath(t[1], t[2]);
+        }
+        else if (cmd == "bfs" || cmd == "dfs") {
+            if (!needsArgs(n, 1, "bfs|dfs <start building>")) return false;
+            traverseCampus(t[1], cmd == "dfs");
+        }
+        else if (cmd == "show-map") {
+            campus.displayAdjacencyList();
+        }
+        // Rooms & scheduling: the building is named on each command instead of selected
+        else if (cmd == "add-room" || cmd == "search-room" || cmd == "reserve" || cmd == "cancel-reservation"
+            || cmd == "list-rooms" || cmd == "rooms-by-type" || cmd == "delete-room"
+            || cmd == "book-slots" || cmd == "cancel-slots" || cmd == "free-rooms") {
+            if (!needsArgs(n, 1, "<room command> <building> ...")) return false;
+            if (!requireLogin(currentUser)) return true;
+            BuildingRooms* building = buildingArg(t[1]);
+            if (!building) return true;
+
+            if (cmd == "add-room") {
+                if (!needsArgs(n, 4, "add-room <building> <id> <floor> <type>") || !numberArg(t[3], a)) return false;
+                insertRoom(building, t[2], a, t[4]);
+            }
+            else if (cmd == "list-rooms") {
+                if (!pinReport(*building->rooms)) building->rooms->displayInorder();
+            }
+            else if (cmd == "free-rooms") {
+                if (!needsArgs(n, 4, "free-rooms <building> <day 1-7> <from hour> <to hour>")
+                    || !numberArg(t[2], a) || !numberArg(t[3], b) || !numberArg(t[4], c)) return false;
+                findFreeRooms(building, a, b, c);
+            }
+            else if (cmd == "book-slots" || cmd == "cancel-slots") {
+                if (!needsArgs(n, 5, "book-slots|cancel-slots <building> <id> <day 1-7> <from hour> <to hour>")
+                    || !numberArg(t[3], a) || !numberArg(t[4], b) || !numberArg(t[5], c)) return false;
+                if (cmd == "book-slots") bookSlots(currentUser, building, t[2], a, b, c);
+                else cancelSlots(currentUser, building, t[2], a, b, c);
+            }
+            else {
+                if (!needsArgs(n, 2, "<room command> <building> <id or type>")) return false;
+                if (cmd == "search-room") searchRoom(building, t[2]);
+                else if (cmd == "reserve") reserveRoom(currentUser, building, t[2]);
+                else if (cmd == "cancel-reservation") cancelReservation(building, t[2]);
+                else if (cmd == "rooms-by-type") building->rooms->displayByType(t[2]);
+                else deleteRoom(building, t[2]);
+            }
+        }
+        // Complaints
+        else if (cmd == "complain") {
+            if (!needsArgs(n, 4, "complain <building> <room> <severity 1-5> <description...>") || !numberArg(t[3], a)) return false;
+            if (requireLogin(currentUser)) submitComplaint(currentUser, t[1], t[2], freeText(t, n, 4), a);
+        }
+        else if (cmd == "process") {
+            if (requireLogin(currentUser)) processComplaint();
+        }
+        else if (cmd == "peek") {
+            if (requireLogin(currentUser)) viewNextComplaint();
+        }
+        else if (cmd == "list-complaints") {
+            if (requireLogin(currentUser) && !pinReport(complaints)) complaints.displayAll();
+        }
+        else if (cmd == "escalate") {
+            if (!needsArgs(n, 2, "escalate <id> <levels>") || !numberArg(t[1], a) || !numberArg(t[2], b)) return false;
+            if (requireLogin(currentUser)) escalateComplaint(a, b);
+        }
+        else if (cmd == "cancel-complaint") {
+            if (!needsArgs(n, 1, "cancel-complaint <id>") || !numberArg(t[1], a)) return false;
+            if (requireLogin(currentUser)) cancelComplaint(a);
+        }
+        else if (cmd == "toggle-priority") {
+            if (requireLogin(currentUser)) togglePriorityMode();
+        }
+        else if (cmd == "dispatch") {
+            if (!needsArgs(n, 1, "dispatch <worker threads>") || !numberArg(t[1], a)) return false;
+            if (requireLogin(currentUser)) dispatchBacklog(a);
         }
+        else if (cmd == "find-complaint") {
+            if (!needsArgs(n, 1, "find-complaint <id>") || !numberArg(t[1], a)) return false;
+            if (requireLogin(currentUser)) findComplaint(a);
+        }
+        else if (cmd == "complaints-at") {
+            if (!needsArgs(n, 1, "complaints-at <building> [room]")) return false;
+            if (requireLogin(currentUser)) complaints.displayByLocation(t[1], n > 2 ? t[2] : "");
+        }
+        else if (cmd == "process-n") {
+            if (!needsArgs(n, 1, "process-n <count>") || !numberArg(t[1], a)) return false;
+            if (requireLogin(currentUser)) processComplaints(a);
+        }
+        else if (cmd == "search-complaints") {
+            if (!needsArgs(n, 1, "search-complaints <words...>")) return false;
+            if (requireLogin(currentUser)) searchComplaints(freeText(t, n, 1));
+        }
+        else if (cmd == "complaints-since") {
+            long long from = 0, until = LLONG_MAX;
+            if (!needsArgs(n, 1, "complaints-since <time> [until time]") || !timeArg(t[1], from)) return false;
+            if (n > 2 && !timeArg(t[2], until)) return false;
+            if (requireLogin(currentUser)) showComplaintsBetween(from, until);
+        }
+        // Messaging
+        else if (cmd == "send") {
+            if (!needsArgs(n, 2, "send <recipient> <text...>")) return false;
+            if (requireLogin(currentUser)) sendMessage(currentUser, t[1], freeText(t, n, 2));
+        }
+        else if (cmd == "inbox") {
+            // Shows the given number of pages (default 1, 0 for all) instead of prompting for more
+            int pages = 1;
+            if (n > 1 && !numberArg(t[1], pages)) return false;
+            if (!requireLogin(currentUser)) return true;
+            InboxView inbox = inboxFor(currentUser);
+            if (inbox.isEmpty()) {
+                cout << "No messages!" << endl;
+                return true;
+            }
+            cout << "=== MESSAGES ===" << endl;
+            InboxCursor cursor;
+            do {
+                cursor = inboxPage(inbox, cursor);
+            } while (!cursor.atEnd() && --pages != 0);
+        }
+        else if (cmd == "new-messages") {
+            if (requireLogin(currentUser)) checkNewMessages(currentUser);
+        }
+        else if (cmd == "messages-since") {
+            long long from = 0;
+            if (!needsArgs(n, 1, "messages-since <time>") || !timeArg(t[1], from)) return false;
+            if (requireLogin(currentUser)) showMessagesSince(currentUser, from);
+        }
+        else if (cmd == "broadcast") {
+            if (!needsArgs(n, 3, "broadcast <role|*> <department|*> <text...>")) return false;
+            if (requireLogin(currentUser)) broadcastMessage(currentUser, t[1], t[2], freeText(t, n, 3));
+        }
+        else if (cmd == "conversation") {
+            if (!needsArgs(n, 1, "conversation <user>")) return false;
+            if (requireLogin(currentUser)) viewConversation(currentUser, t[1]);
+        }
+        else if (cmd == "search-messages") {
+            if (!needsArgs(n, 1, "search-messages <words...>")) return false;
+            if (requireLogin(currentUser)) searchMessages(currentUser, freeText(t, n, 1));
+        }
+        // Stats
+        else if (cmd == "stats") {
+            if (requireAdmin(currentUser)) showStats();
+        }
+        else if (cmd == "stats-dump") {
+            if (!needsArgs(n, 1, "stats-dump <file>")) return false;
+            if (localOnly("stats-dump") && requireAdmin(currentUser)) dumpStats(t[1]);
+        }
+        else if (cmd == "stats-reset") {
+            if (requireAdmin(currentUser)) resetStats();
+        }
+        // Export
+        else if (cmd == "export") {
+            ExportFormat format = EXPORT_CSV;
+            ExportSink sink = SINK_BUFFERED;
+            if (!needsArgs(n, 3, "export <users|rooms|map|complaints|messages> <csv|jsonl> <file> [buffered|writev|mmap]")
+                || !exportArgs(t, n, format, sink)) return false;
+            if (localOnly("export") && requireAdmin(currentUser, "export data")) exportData(t[1], format, sink, t[3]);
+        }
+        // Autocomplete
+        else if (cmd == "complete") {
+            if (!needsArgs(n, 1, "complete <prefix> [user|building|room]")) return false;
+            autocomplete(t[1], n > 2 ? t[2] : "");
+        }
+        else {
+            cout << "Unknown command: " << cmd << endl;
+            return false;
+        }
+        return true;
     }
 
-    void run() {
-        User* currentUser = nullptr;
-        int choice;
+    // ---------- Interactive menus ----------
+
+    void autocompleteLookup() {
+        string prefix, kind;
+        cout << "Prefix: "; getline(cin, prefix);
+        cout << "Kind (user/building/room, blank for all): "; getline(cin, kind);
+        autocomplete(prefix, kind);
+    }
 
+    void statsMenu(User* currentUser) {
+        if (!requireAdmin(currentUser)) return;
+
+        int choice;
         do {
-            cout << "\n===== UNIVERSITY MANAGEMENT SYSTEM =====" << endl;
-            if (currentUser) {
-                cout << "Logged in as: " << currentUser->userName
-                    << " (" << currentUser->role << ")" << endl;
-            }
-            cout << "1. User & Authentication" << endl;
-            cout << "2. Campus Map" << endl;
-            cout << "3. Rooms & Scheduling" << endl;
-            cout << "4. Complaints" << endl;
-            cout << "5. Messaging" << endl;
-            cout << "6. Exit" << endl;
+            cout << "\n===== STATS =====" << endl;
+            cout << "1. View Counters & Latencies" << endl;
+            cout << "2. Dump Prometheus Text File" << endl;
+            cout << "3. Reset Stats" << endl;
+            cout << "4. Back" << endl;
             cout << "Choice: ";
             cin >> choice;
             cin.ignore();
 
             switch (choice) {
             case 1:
-                userMenu(currentUser);
+                showStats();
                 break;
-            case 2: 
-                campusMenu(); 
+            case 2: {
+                string path;
+                cout << "File path: "; getline(cin, path);
+                dumpStats(path);
                 break;
+            }
             case 3:
-                roomsMenu(currentUser); 
-                break;
-            case 4: 
-                complaintsMenu(currentUser); 
-                break;
-            case 5: 
-                messagingMenu(currentUser);
-                break;
-            case 6: 
-                cout << "Goodbye!" << endl; 
+                resetStats();
                 break;
-            default: 
+            case 4:
+                return;
+            default:
                 cout << "Invalid choice!" << endl;
             }
-        } while (choice != 6);
+        } while (true);
     }
 
-private:
     void userMenu(User*& currentUser) {
         int choice;
         do {
@@ -1001,27 +7208,54 @@ private:
             cin.ignore();
 
             switch (choice) {
-            case 1: 
-                registerUser(); 
+            case 1: {
+                string uname, pwd, role, dept, email;
+                cout << "Username: "; getline(cin, uname);
+                cout << "Password: "; getline(cin, pwd);
+                cout << "Role (student/teacher/admin): "; getline(cin, role);
+                cout << "Department: "; getline(cin, dept);
+                cout << "Email: "; getline(cin, email);
+                registerUser(uname, pwd, role, dept, email);
                 break;
-            case 2: 
-                loginUser(currentUser); 
+            }
+            case 2: {
+                if (currentUser) {
+                    cout << "Already logged in as " << currentUser->userName << endl;
+                    break;
+                }
+                string uname, pwd;
+                cout << "Username: "; getline(cin, uname);
+                cout << "Password: "; getline(cin, pwd);
+                loginUser(currentUser, uname, pwd);
                 break;
-            case 3:
-                updateProfile(currentUser);
+            }
+            case 3: {
+                if (!requireLogin(currentUser)) break;
+                string pwd, dept, email;
+                cout << "Leave blank to keep current value" << endl;
+                cout << "New Password: "; getline(cin, pwd);
+                cout << "New Department: "; getline(cin, dept);
+                cout << "New Email: "; getline(cin, email);
+                updateProfile(currentUser, pwd, dept, email);
                 break;
-            case 4: 
-                deleteUser(); 
+            }
+            case 4: {
+                string uname;
+                cout << "Username to delete: "; getline(cin, uname);
+                deleteUser(currentUser, uname);
                 break;
-            case 5: 
-                searchUser(); 
+            }
+            case 5: {
+                string uname;
+                cout << "Username to search: "; getline(cin, uname);
+                searchUser(uname);
                 break;
+            }
             case 6: 
                 users.displayAllUsers(); 
                 break;
             case 7:
-                currentUser = nullptr; 
-                cout << "Logged out." << endl; 
+                logoutUser(currentUser);
                 break;
             case 8: 
                 return;
@@ -1031,94 +7265,6 @@ private:
         } while (true);
     }
 
-    void registerUser() {
-        string uname, pwd, role, dept, email;
-
-        cout << "Username: "; getline(cin, uname);
-        cout << "Password: "; getline(cin, pwd);
-        cout << "Role (student/teacher/admin): "; getline(cin, role);
-        cout << "Department: "; getline(cin, dept);
-        cout << "Email: "; getline(cin, email);
-
-        if (users.registerUser(uname, pwd, role, dept, email)) {
-            cout << "Registration successful!" << endl;
-        }
-        else {
-            cout << "Registration failed!" << endl;
-        }
-    }
-
-    void loginUser(User*& currentUser) {
-        if (currentUser) {
-            cout << "Already logged in as " << currentUser->userName << endl;
-            return;
-        }
-
-        string uname, pwd;
-        cout << "Username: "; getline(cin, uname);
-        cout << "Password: "; getline(cin, pwd);
-
-        currentUser = users.login(uname, pwd);
-        if (currentUser) {
-            cout << "Login successful! Welcome " << currentUser->userName << endl;
-        }
-        else {
-            cout << "Invalid credentials!" << endl;
-        }
-    }
-
-    void updateProfile(User* currentUser) {
-        if (!currentUser) {
-            cout << "Please login first!" << endl;
-            return;
-        }
-
-        string pwd, dept, email;
-        cout << "Leave blank to keep current value" << endl;
-        cout << "New Password: "; getline(cin, pwd);
-        cout << "New Department: "; getline(cin, dept);
-        cout << "New Email: "; getline(cin, email);
-
-        if (users.updateUser(currentUser->userName, pwd, dept, email)) {
-            cout << "Profile updated successfully!" << endl;
-        }
-        else {
-            cout << "Update failed!" << endl;
-        }
-    }
-
-    void deleteUser() {
-        string uname;
-        cout << "Username to delete: "; getline(cin, uname);
-
-        if (users.deleteUser(uname)) {
-            cout << "User deleted successfully!" << endl;
-        }
-        else {
-            cout << "User not found!" << endl;
-        }
-    }
-
-    void searchUser() {
-        string uname;
-        cout << "Username to search: "; getline(cin, uname);
-
-        User* user = users.searchUser(uname);
-        if (user) {
-            cout << "User found:" << endl;
-            cout << "Username: " << user->userName << endl;
-            cout << "Role: " << user->role << endl;
-            cout << "Department: " << user->department << endl;
-            cout << "Email: " << user->email << endl;
-            if (!user->lastBookedRoom.empty()) {
-                cout << "Last booked room: " << user->lastBookedRoom << endl;
-            }
-        }
-        else {
-            cout << "User not found!" << endl;
-        }
-    }
-
     void campusMenu() {
         int choice;
         do {
@@ -1139,36 +7285,13 @@ private:
             case 1: {
                 string name;
                 cout << "Building name: "; getline(cin, name);
-                if (campus.addBuilding(name)) {
-                    BuildingRooms* newBR = new BuildingRooms(name);
-                    newBR->next = buildingRooms;
-                    buildingRooms = newBR;
-                    cout << "Building added!" << endl;
-                }
+                addBuilding(name);
                 break;
             }
             case 2: {
                 string name;
                 cout << "Building name to remove: "; getline(cin, name);
-                if (campus.removeBuilding(name)) {
-                    BuildingRooms* current = buildingRooms;
-                    BuildingRooms* prev = nullptr;
-                    while (current) {
-                        if (current->name == name) {
-                            if (prev) {
-                                prev->next = current->next;
-                            }
-                            else {
-                                buildingRooms = current->next;
-                            }
-                            delete current;
-                            cout << "Building and its rooms removed!" << endl;
-                            break;
-                        }
-                        prev = current;
-                        current = current->next;
-                    }
-                }
+                deleteBuilding(name);
                 break;
             }
             case 3: {
@@ -1177,26 +7300,26 @@ private:
                 cout << "Source building: "; getline(cin, src);
                 cout << "Destination building: "; getline(cin, dest);
                 cout << "Distance: "; cin >> dist; cin.ignore();
-                campus.addPath(src, dest, dist);
+                addPath(src, dest, dist);
                 break;
             }
             case 4: {
                 string src, dest;
                 cout << "Source building: "; getline(cin, src);
                 cout << "Destination building: "; getline(cin, dest);
-                campus.removePath(src, dest);
+                removePath(src, dest);
                 break;
             }
             case 5: {
                 string start;
                 cout << "Start building: "; getline(cin, start);
-                campus.BFS(start);
+                traverseCampus(start, false);
                 break;
             }
             case 6: {
                 string start;
                 cout << "Start building: "; getline(cin, start);
-                campus.DFS(start);
+                traverseCampus(start, true);
                 break;
             }
             case 7: 
@@ -1211,10 +7334,7 @@ private:
     }
 
     void roomsMenu(User* currentUser) {
-        if (!currentUser) {
-            cout << "Please login first!" << endl;
-            return;
-        }
+        if (!requireLogin(currentUser)) return;
 
         int choice;
         BuildingRooms* selectedBuilding = nullptr;
@@ -1231,11 +7351,20 @@ private:
             cout << "5. Cancel Reservation" << endl;
             cout << "6. Display Rooms" << endl;
             cout << "7. Search by Type" << endl;
-            cout << "8. Back" << endl;
+            cout << "8. Delete Room" << endl;
+            cout << "9. Book Weekly Slots" << endl;
+            cout << "10. Cancel Weekly Slots" << endl;
+            cout << "11. Find Free Rooms" << endl;
+            cout << "12. Back" << endl;
             cout << "Choice: ";
             cin >> choice;
             cin.ignore();
 
+            if (choice >= 2 && choice <= 11 && !selectedBuilding) {
+                cout << "Please select a building first!" << endl;
+                continue;
+            }
+
             switch (choice) {
             case 1: {
                 string name;
@@ -1251,94 +7380,74 @@ private:
                 break;
             }
             case 2: {
-                if (!selectedBuilding) {
-                    cout << "Please select a building first!" << endl;
-                    break;
-                }
                 string id, type;
                 int floor;
                 cout << "Room ID: "; getline(cin, id);
                 cout << "Floor: "; cin >> floor; cin.ignore();
                 cout << "Type (classroom/lab/office): "; getline(cin, type);
-                selectedBuilding->rooms->insertRoom(Room(id, floor, type));
-                cout << "Room added!" << endl;
+                insertRoom(selectedBuilding, id, floor, type);
                 break;
             }
             case 3: {
-                if (!selectedBuilding) {
-                    cout << "Please select a building first!" << endl;
-                    break;
-                }
                 string id;
                 cout << "Room ID to search: "; getline(cin, id);
-                Room* room = selectedBuilding->rooms->searchRoom(id);
-                if (room) {
-                    cout << "Room found:" << endl;
-                    cout << "ID: " << room->id << endl;
-                    cout << "Floor: " << room->floor << endl;
-                    cout << "Type: " << room->type << endl;
-                    cout << "Reserved: " << (room->reserved ? "Yes" : "No") << endl;
-                    if (room->reserved) {
-                        cout << "Reserved by: " << room->reservedBy << endl;
-                    }
-                }
-                else {
-                    cout << "Room not found!" << endl;
-                }
+                searchRoom(selectedBuilding, id);
                 break;
             }
-            case 4: {
-                if (!selectedBuilding) {
-                    cout << "Please select a building first!" << endl;
-                    break;
-                }
+            case 4: {
                 string roomID;
                 cout << "Room ID to reserve: ";
                 getline(cin, roomID);
-                if (selectedBuilding->rooms->reserveRoom(roomID, currentUser->userName)) {
-                    users.updateLastBookedRoom(currentUser->userName, roomID);
-                    cout << "Room reserved successfully!" << endl;
-                }
-                else {
-                    cout << "Reservation failed! Room might be already reserved or not found." << endl;
-                }
+                reserveRoom(currentUser, selectedBuilding, roomID);
                 break;
             }
             case 5: {
-                if (!selectedBuilding) {
-                    cout << "Please select a building first!" << endl;
-                    break;
-                }
                 string roomID;
                 cout << "Room ID to cancel: "; 
                 getline(cin, roomID);
-                if (selectedBuilding->rooms->cancelReservation(roomID)) {
-                    cout << "Reservation cancelled!" << endl;
-                }
-                else {
-                    cout << "Cancellation failed! Room might not be reserved." << endl;
-                }
+                cancelReservation(selectedBuilding, roomID);
                 break;
             }
-            case 6: {
-                if (!selectedBuilding) {
-                    cout << "Please select a building first!" << endl;
-                    break;
-                }
+            case 6:
                 selectedBuilding->rooms->displayInorder();
                 break;
-            }
             case 7: {
-                if (!selectedBuilding) {
-                    cout << "Please select a building first!" << endl;
-                    break;
-                }
                 string type;
                 cout << "Room type to search: "; getline(cin, type);
                 selectedBuilding->rooms->displayByType(type);
                 break;
             }
-            case 8:
+            case 8: {
+                string roomID;
+                cout << "Room ID to delete: "; getline(cin, roomID);
+                deleteRoom(selectedBuilding, roomID);
+                break;
+            }
+            case 9:
+            case 10: {
+                string roomID;
+                int day, fromHour, toHour;
+                cout << "Room ID: "; getline(cin, roomID);
+                cout << "Day (1=Mon .. 7=Sun): "; cin >> day;
+                cout << "From hour (0-23): "; cin >> fromHour;
+                cout << "To hour (0-23): "; cin >> toHour; cin.ignore();
+                if (choice == 9) {
+                    bookSlots(currentUser, selectedBuilding, roomID, day, fromHour, toHour);
+                }
+                else {
+                    cancelSlots(currentUser, selectedBuilding, roomID, day, fromHour, toHour);
+                }
+                break;
+            }
+            case 11: {
+                int day, fromHour, toHour;
+                cout << "Day (1=Mon .. 7=Sun): "; cin >> day;
+                cout << "From hour (0-23): "; cin >> fromHour;
+                cout << "To hour (0-23): "; cin >> toHour; cin.ignore();
+                findFreeRooms(selectedBuilding, day, fromHour, toHour);
+                break;
+            }
+            case 12:
                 return;
             default: 
                 cout << "Invalid choice!" << endl;
@@ -1347,20 +7456,27 @@ private:
     }
 
     void complaintsMenu(User* currentUser) {
-        if (!currentUser) {
-            cout << "Please login first!" << endl;
-            return;
-        }
+        if (!requireLogin(currentUser)) return;
 
         int choice;
         do {
             cout << "\n===== COMPLAINT SYSTEM =====" << endl;
-            cout << "Pending complaints: " << complaints.getSize() << endl;
+            cout << "Pending complaints: " << complaints.getSize()
+                << " | Mode: " << (complaints.isPriorityMode() ? "Priority" : "FIFO") << endl;
             cout << "1. Submit Complaint" << endl;
             cout << "2. Process Next Complaint" << endl;
             cout << "3. View Next Complaint" << endl;
             cout << "4. Display All Complaints" << endl;
-            cout << "5. Back" << endl;
+            cout << "5. Escalate Complaint" << endl;
+            cout << "6. Cancel Complaint" << endl;
+            cout << "7. Toggle Priority Mode" << endl;
+            cout << "8. Dispatch Backlog to Workers" << endl;
+            cout << "9. Find Complaint by ID" << endl;
+            cout << "10. Find Complaints by Location" << endl;
+            cout << "11. Process Next N Complaints" << endl;
+            cout << "12. Search Complaints" << endl;
+            cout << "13. Complaints Filed Since" << endl;
+            cout << "14. Back" << endl;
             cout << "Choice: ";
             cin >> choice;
             cin.ignore();
@@ -1369,29 +7485,78 @@ private:
                 switch (choice) {
                 case 1: {
                     string bldg, room, desc;
+                    int severity;
                     cout << "Building: "; getline(cin, bldg);
                     cout << "Room: "; getline(cin, room);
                     cout << "Description: "; getline(cin, desc);
-                    complaints.enqueue(currentUser->userName, bldg, room, desc, getCurrentTime());
-                    cout << "Complaint submitted!" << endl;
+                    cout << "Severity (1-5): "; cin >> severity; cin.ignore();
+                    submitComplaint(currentUser, bldg, room, desc, severity);
                     break;
                 }
-                case 2: {
-                    Complaint c = complaints.dequeue();
-                    cout << "Processing complaint:" << endl;
-                    c.display();
+                case 2:
+                    processComplaint();
                     break;
-                }
-                case 3: {
-                    Complaint c = complaints.peek();
-                    cout << "Next complaint to process:" << endl;
-                    c.display();
+                case 3:
+                    viewNextComplaint();
                     break;
-                }
                 case 4: 
                     complaints.displayAll(); 
                     break;
-                case 5: 
+                case 5: {
+                    int id, levels;
+                    cout << "Complaint ID: "; cin >> id;
+                    cout << "Levels to raise: "; cin >> levels; cin.ignore();
+                    escalateComplaint(id, levels);
+                    break;
+                }
+                case 6: {
+                    int id;
+                    cout << "Complaint ID: "; cin >> id; cin.ignore();
+                    cancelComplaint(id);
+                    break;
+                }
+                case 7:
+                    togglePriorityMode();
+                    break;
+                case 8: {
+                    int workerThreads;
+                    cout << "Worker threads: "; cin >> workerThreads; cin.ignore();
+                    dispatchBacklog(workerThreads);
+                    break;
+                }
+                case 9: {
+                    int id;
+                    cout << "Complaint ID: "; cin >> id; cin.ignore();
+                    findComplaint(id);
+                    break;
+                }
+                case 10: {
+                    string bldg, room;
+                    cout << "Building: "; getline(cin, bldg);
+                    cout << "Room (blank for whole building): "; getline(cin, room);
+                    complaints.displayByLocation(bldg, room);
+                    break;
+                }
+                case 11: {
+                    int n;
+                    cout << "How many: "; cin >> n; cin.ignore();
+                    processComplaints(n);
+                    break;
+                }
+                case 12: {
+                    string query;
+                    cout << "Search words: "; getline(cin, query);
+                    searchComplaints(query);
+                    break;
+                }
+                case 13: {
+                    string when;
+                    long long from;
+                    cout << "Since (30m, 2h, 1d, today, monday or YYYY-MM-DD [HH:MM]): "; getline(cin, when);
+                    if (timeArg(when, from)) showComplaintsBetween(from, LLONG_MAX);
+                    break;
+                }
+                case 14: 
                     return;
                 default: 
                     cout << "Invalid choice!" << endl;
@@ -1404,10 +7569,7 @@ private:
     }
 
     void messagingMenu(User* currentUser) {
-        if (!currentUser) {
-            cout << "Please login first!" << endl;
-            return;
-        }
+        if (!requireLogin(currentUser)) return;
 
         int choice;
         do {
@@ -1416,7 +7578,11 @@ private:
             cout << "1. Send Message" << endl;
             cout << "2. View My Messages" << endl;
             cout << "3. Check New Messages" << endl;
-            cout << "4. Back" << endl;
+            cout << "4. Broadcast Message (admin)" << endl;
+            cout << "5. View Conversation" << endl;
+            cout << "6. Search Messages (admin)" << endl;
+            cout << "7. Messages Since" << endl;
+            cout << "8. Back" << endl;
             cout << "Choice: ";
             cin >> choice;
             cin.ignore();
@@ -1427,56 +7593,64 @@ private:
                     string to, text;
                     cout << "Recipient username: "; getline(cin, to);
                     cout << "Message: "; getline(cin, text);
-
-                    if (!users.searchUser(to)) {
-                        cout << "Recipient not found!" << endl;
-                        break;
-                    }
-
-                    UserMessages* senderMsgs = findUserMessages(currentUser->userName);
-                    if (!senderMsgs) {
-                        senderMsgs = new UserMessages(currentUser->userName);
-                        senderMsgs->next = userMessages;
-                        userMessages = senderMsgs;
-                    }
-
-                    Message msg(currentUser->userName, to, text, getCurrentTime());
-                    senderMsgs->messages->push(msg);
-
-                    UserMessages* recipientMsgs = findUserMessages(to);
-                    if (!recipientMsgs) {
-                        recipientMsgs = new UserMessages(to);
-                        recipientMsgs->next = userMessages;
-                        userMessages = recipientMsgs;
-                    }
-                    recipientMsgs->messages->push(msg);
-
-                    cout << "Message sent!" << endl;
+                    sendMessage(currentUser, to, text);
                     break;
                 }
                 case 2: {
-                    UserMessages* myMsgs = findUserMessages(currentUser->userName);
-                    if (myMsgs && !myMsgs->messages->isEmpty()) {
-                        myMsgs->messages->display();
-                    }
-                    else {
+                    InboxView inbox = inboxFor(currentUser);
+                    if (inbox.isEmpty()) {
                         cout << "No messages!" << endl;
+                        break;
+                    }
+                    cout << "=== MESSAGES ===" << endl;
+                    InboxCursor cursor = inboxPage(inbox, InboxCursor());
+                    while (!cursor.atEnd()) {
+                        string more;
+                        cout << "More? (y/n): "; getline(cin, more);
+                        if (more != "y" && more != "Y") break;
+                        cursor = inboxPage(inbox, cursor);
                     }
                     break;
                 }
-                case 3: {
-                    UserMessages* myMsgs = findUserMessages(currentUser->userName);
-                    if (myMsgs && !myMsgs->messages->isEmpty()) {
-                        cout << "Latest message:" << endl;
-                        Message msg = myMsgs->messages->peek();
-                        msg.display();
+                case 3:
+                    checkNewMessages(currentUser);
+                    break;
+                case 4: {
+                    if (currentUser->role != ROLE_ADMIN) {
+                        cout << "Only admins can broadcast!" << endl;
+                        break;
                     }
-                    else {
-                        cout << "No messages!" << endl;
+                    string role, dept, text;
+                    cout << "Target role (student/teacher/admin, * for all): "; getline(cin, role);
+                    cout << "Target department (* for all): "; getline(cin, dept);
+                    cout << "Message: "; getline(cin, text);
+                    broadcastMessage(currentUser, role, dept, text);
+                    break;
+                }
+                case 5: {
+                    string other;
+                    cout << "Other username: "; getline(cin, other);
+                    viewConversation(currentUser, other);
+                    break;
+                }
+                case 6: {
+                    if (currentUser->role != ROLE_ADMIN) {
+                        cout << "Only admins can search messages!" << endl;
+                        break;
                     }
+                    string query;
+                    cout << "Search words: "; getline(cin, query);
+                    searchMessages(currentUser, query);
                     break;
                 }
-                case 4: 
+                case 7: {
+                    string when;
+                    long long from;
+                    cout << "Since (30m, 2h, 1d, today, monday or YYYY-MM-DD [HH:MM]): "; getline(cin, when);
+                    if (timeArg(when, from)) showMessagesSince(currentUser, from);
+                    break;
+                }
+                case 8: 
                     return;
                 default: 
                     cout << "Invalid choice!" << endl;
@@ -1488,7 +7662,815 @@ private:
         } while (true);
     }
 };
-int main() {
+
+// ==================== SNAPSHOT BENCHMARK ====================
+// Write throughput with and without a report running next to the writer. A
+// reader thread cycles through list-users, list-rooms and list-complaints,
+// either printing under the system lock or printing a pinned version after
+// releasing it, while the writer registers and deletes users, reserves and
+// frees rooms and files and processes complaints.
+
+// Formats into nowhere, so reports still pay for formatting
+class DiscardBuffer : public streambuf {
+protected:
+    int overflow(int ch) override {
+        return ch == EOF ? 0 : ch;
+    }
+
+    streamsize xsputn(const char*, streamsize count) override {
+        return count;
+    }
+};
+
+enum ReportMode { REPORT_NONE, REPORT_LOCKED, REPORT_PINNED };
+
+struct SnapshotBenchState {
+    UniversitySystem* system;
+    mutex lock; // stands in for the server's system lock
+    atomic<bool> stop;
+    ReportMode mode;
+    string readerSession;
+    long long reports;
+};
+
+void runReportLoop(SnapshotBenchState* state) {
+    DiscardBuffer sink;
+    ostream out(&sink);
+    const string reports[3][2] = { { "list-users", "" }, { "list-rooms", "Bench" }, { "list-complaints", "" } };
+    const int tokenCounts[3] = { 1, 2, 1 };
+
+    for (int i = 0; !state->stop.load(); i = (i + 1) % 3) {
+        ReportPin pin;
+        {
+            lock_guard<mutex> guard(state->lock);
+            state->system->executeRequest(reports[i], tokenCounts[i], state->readerSession,
+                state->mode == REPORT_PINNED ? &pin : nullptr);
+        }
+        if (pin.guard) pin.printAndRelease(out);
+        state->reports++;
+    }
+}
+
+// One line of the write mix; every six writes leave the system as they found it
+int snapshotBenchWrite(long long i, int roomCount, string* tokens) {
+    string user = "bench" + to_string(i / 6);
+    string room = "R" + to_string((i / 6) % roomCount);
+    switch (i % 6) {
+    case 0:
+        tokens[0] = "register"; tokens[1] = user; tokens[2] = "pw"; tokens[3] = "student";
+        tokens[4] = "Bench"; tokens[5] = user + "@nu.edu.pk";
+        return 6;
+    case 1:
+        tokens[0] = "reserve"; tokens[1] = "Bench"; tokens[2] = room;
+        return 3;
+    case 2:
+        tokens[0] = "complain"; tokens[1] = "Bench"; tokens[2] = room; tokens[3] = "2";
+        tokens[4] = "projector"; tokens[5] = to_string(i);
+        return 6;
+    case 3:
+        tokens[0] = "cancel-reservation"; tokens[1] = "Bench"; tokens[2] = room;
+        return 3;
+    case 4:
+        tokens[0] = "process";
+        return 1;
+    default:
+        tokens[0] = "delete-user"; tokens[1] = user;
+        return 2;
+    }
+}
+
+void benchmarkSnapshotReads(int userCount, int roomCount, double seconds) {
+    DiscardBuffer sink;
+    streambuf* console = cout.rdbuf(&sink);
+    UniversitySystem* system = new UniversitySystem();
+    string writerSession;
+    string tokens[MAX_COMMAND_TOKENS];
+
+    // Setup runs through the same request path, as admin
+    const string login[3] = { "login", "admin", "admin123" };
+    system->executeRequest(login, 3, writerSession);
+    const string building[2] = { "add-building", "Bench" };
+    system->executeRequest(building, 2, writerSession);
+    for (int i = 0; i < userCount; i++) {
+        const string line[6] = { "register", "user" + to_string(i), "pw", "student", "Bench", "u@nu.edu.pk" };
+        system->executeRequest(line, 6, writerSession);
+    }
+    for (int i = 0; i < roomCount; i++) {
+        const string line[5] = { "add-room", "Bench", "R" + to_string(i), to_string(i % 10), "classroom" };
+        system->executeRequest(line, 5, writerSession);
+    }
+    for (int i = 0; i < roomCount / 10; i++) {
+        const string line[6] = { "complain", "Bench", "R" + to_string(i), "1", "heating", to_string(i) };
+        system->executeRequest(line, 6, writerSession);
+    }
+    cout.rdbuf(console);
+
+    cout << "Snapshot reads: " << userCount << " users, " << roomCount << " rooms, "
+        << roomCount / 10 << " open complaints, " << seconds << " s per mode" << endl;
+    cout << "report\twrites/s\tp50 us\tp99 us\tmax us\treports/s" << endl;
+    const char* modeNames[3] = { "none", "locked", "pinned" };
+    long long* slots = new long long[LATENCY_SLOTS];
+    long long next = 0;
+
+    for (int mode = REPORT_NONE; mode <= REPORT_PINNED; mode++) {
+        SnapshotBenchState state;
+        state.system = system;
+        state.stop = false;
+        state.mode = (ReportMode)mode;
+        state.reports = 0;
+        cout.rdbuf(&sink);
+        system->executeRequest(login, 3, state.readerSession);
+
+        thread reader;
+        if (mode != REPORT_NONE) reader = thread(runReportLoop, &state);
+        for (int s = 0; s < LATENCY_SLOTS; s++) slots[s] = 0;
+        long long writes = 0, worst = 0;
+        long long startedAt = steadyNanos();
+        long long deadline = startedAt + (long long)(seconds * 1e9);
+        // Whole cycles only, so every mode starts from the same state
+        while (steadyNanos() < deadline || next % 6 != 0) {
+            int count = snapshotBenchWrite(next++, roomCount, tokens);
+            long long sentAt = steadyNanos();
+            {
+                lock_guard<mutex> guard(state.lock);
+                system->executeRequest(tokens, count, writerSession);
+            }
+            long long took = steadyNanos() - sentAt;
+            slots[latencySlot(took)]++;
+            if (took > worst) worst = took;
+            writes++;
+        }
+        double elapsed = (steadyNanos() - startedAt) / 1e9;
+        state.stop = true;
+        if (reader.joinable()) reader.join();
+        cout.rdbuf(console);
+
+        char line[160];
+        snprintf(line, sizeof(line), "%s\t%.0f\t%.1f\t%.1f\t%.1f\t%.1f", modeNames[mode], writes / elapsed,
+            Metrics::percentile(slots, writes, 0.50) / 1e3, Metrics::percentile(slots, writes, 0.99) / 1e3,
+            worst / 1e3, state.reports / elapsed);
+        cout << line << endl;
+    }
+    delete[] slots;
+
+    cout.rdbuf(&sink);
+    delete system;
+    cout.rdbuf(console);
+}
+
+// ==================== SERVER MODULE ====================
+// Local multi-client mode. One poll thread accepts connections and splits
+// their input into request lines; a fixed pool of workers runs the lines
+// against the shared UniversitySystem and writes the replies. Requests from
+// one connection run one at a time, in order. The system sits behind one
+// lock: even lookups touch shared state (traversal marks, read markers, the
+// timestamp counter), so commands are serialized while socket I/O, parsing
+// and reply framing overlap across workers.
+//
+// Protocol: the client sends batch commands (see README), one per line.
+// Each line gets one reply: a header line "OK <bytes>", "REJECTED <bytes>"
+// or "BYE <bytes>", followed by exactly that many bytes of command output.
+#ifndef _WIN32
+
+volatile sig_atomic_t serverStopRequested = 0;
+
+void requestServerStop(int) {
+    serverStopRequested = 1;
+}
+
+// All digits names a localhost TCP port; anything else is a Unix socket path
+int openServerSocket(const string& address, bool listening) {
+    bool tcp = !address.empty() && address.find_first_not_of("0123456789") == string::npos;
+    int fd = socket(tcp ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    int result;
+    if (tcp) {
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)atoi(address.c_str()));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        if (listening) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        result = listening ? bind(fd, (sockaddr*)&addr, sizeof(addr)) : connect(fd, (sockaddr*)&addr, sizeof(addr));
+    }
+    else {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (address.size() >= sizeof(addr.sun_path)) {
+            close(fd);
+            return -1;
+        }
+        memcpy(addr.sun_path, address.c_str(), address.size() + 1);
+        if (listening) unlink(address.c_str());
+        result = listening ? bind(fd, (sockaddr*)&addr, sizeof(addr)) : connect(fd, (sockaddr*)&addr, sizeof(addr));
+        // Owner only; nobody can connect before listen(), so there is no window
+        if (result == 0 && listening) result = chmod(address.c_str(), 0600);
+    }
+    if (result == 0 && listening) result = listen(fd, 128);
+    if (result != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool sendAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        data += sent;
+        length -= sent;
+    }
+    return true;
+}
+
+// cout sink for one reply; the string keeps its capacity between requests
+class ResponseBuffer : public streambuf {
+private:
+    string& out;
+
+protected:
+    int overflow(int ch) override {
+        if (ch != EOF) out += (char)ch;
+        return ch == EOF ? 0 : ch;
+    }
+
+    streamsize xsputn(const char* text, streamsize count) override {
+        out.append(text, count);
+        return count;
+    }
+
+public:
+    ResponseBuffer(string& target) : out(target) {}
+};
+
+struct ServerConnection {
+    int fd;
+    string input;       // received bytes not yet split into lines
+    LinkedQueue<string, HeapAllocator, 4> pending; // request lines, oldest first
+    string sessionToken; // empty when logged out
+    bool busy;          // queued for or held by a worker
+    bool watched;       // still in the poll set
+    bool finished;      // said exit or broke; no further requests are served
+    mutex lock;
+
+    ServerConnection(int socket) : fd(socket), busy(false), watched(true), finished(false) {}
+
+    ~ServerConnection() {
+        close(fd);
+    }
+};
+
+// Connections with a request waiting, handed from the poll thread to workers
+class ReadyQueue {
+private:
+    LinkedQueue<ServerConnection*> ready;
+    mutex lock;
+    condition_variable wake;
+    bool closing;
+
+public:
+    ReadyQueue() : closing(false) {}
+
+    void push(ServerConnection* connection) {
+        {
+            lock_guard<mutex> guard(lock);
+            ready.pushBack(connection);
+        }
+        wake.notify_one();
+    }
+
+    // Blocks for the next connection; nullptr once closed and drained
+    ServerConnection* pop() {
+        unique_lock<mutex> guard(lock);
+        wake.wait(guard, [this] { return closing || !ready.isEmpty(); });
+        return ready.isEmpty() ? nullptr : ready.popFront();
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> guard(lock);
+            closing = true;
+        }
+        wake.notify_all();
+    }
+};
+
+class UniverseServer {
+private:
+    static const int MAX_LINE = 1 << 16;
+
+    UniversitySystem& system;
+    mutex systemLock;
+    ReadyQueue ready;
+    string address;
+    int listenFd;
+    atomic<long long> served;
+    long long accepted;
+
+    // Poll set: slot 0 is the listening socket, slot i > 0 watches connections[i]
+    pollfd* fds;
+    ServerConnection** connections;
+    int count;
+    int capacity;
+
+    void watch(int fd) {
+        if (count == capacity) {
+            pollfd* newFds = new pollfd[capacity * 2];
+            ServerConnection** newConnections = new ServerConnection * [capacity * 2];
+            for (int i = 0; i < count; i++) {
+                newFds[i] = fds[i];
+                newConnections[i] = connections[i];
+            }
+            delete[] fds;
+            delete[] connections;
+            fds = newFds;
+            connections = newConnections;
+            capacity *= 2;
+        }
+        fds[count].fd = fd;
+        fds[count].events = POLLIN;
+        fds[count].revents = 0;
+        connections[count] = fd == listenFd ? nullptr : new ServerConnection(fd);
+        count++;
+    }
+
+    void acceptConnection() {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) return;
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)); // fails harmlessly on Unix sockets
+        watch(fd);
+        accepted++;
+    }
+
+    // Splits newly received bytes into request lines and hands the connection
+    // to a worker if none holds it. Returns false when it should be dropped.
+    bool receive(ServerConnection* connection) {
+        char buffer[4096];
+        ssize_t received = recv(connection->fd, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) return true;
+        if (received <= 0) return false;
+
+        lock_guard<mutex> guard(connection->lock);
+        if (connection->finished) return true;
+        connection->input.append(buffer, received);
+        size_t start = 0, end;
+        while ((end = connection->input.find('\n', start)) != string::npos) {
+            connection->pending.pushBack(connection->input.substr(start, end - start));
+            start = end + 1;
+        }
+        connection->input.erase(0, start);
+        if (connection->input.size() > MAX_LINE) return false;
+
+        if (!connection->busy && !connection->pending.isEmpty()) {
+            connection->busy = true;
+            ready.push(connection);
+        }
+        return true;
+    }
+
+    // Stops watching slot i; the connection is freed here unless a worker holds it
+    void hangUp(int i) {
+        ServerConnection* connection = connections[i];
+        count--;
+        fds[i] = fds[count];
+        connections[i] = connections[count];
+
+        bool idle;
+        {
+            lock_guard<mutex> guard(connection->lock);
+            connection->watched = false;
+            connection->finished = true;
+            idle = !connection->busy;
+        }
+        if (idle) delete connection;
+    }
+
+    void serveRequests() {
+        string output;
+        ResponseBuffer capture(output);
+        ostream reportOut(&capture);
+        string reply;
+        string tokens[MAX_COMMAND_TOKENS];
+        size_t starts[MAX_COMMAND_TOKENS];
+
+        while (ServerConnection* connection = ready.pop()) {
+            string line;
+            {
+                lock_guard<mutex> guard(connection->lock);
+                line = connection->pending.popFront();
+            }
+
+            long long startedAt = steadyNanos();
+            const char* status = "OK";
+            bool bye = false;
+            output.clear();
+            int tokenCount = tokenizeCommand(line, tokens, MAX_COMMAND_TOKENS, starts);
+            if (tokenCount > 0 && (tokens[0] == "exit" || tokens[0] == "quit")) {
+                status = "BYE";
+                bye = true;
+            }
+            else if (tokenCount > 0) {
+                // Reports are pinned under the lock and printed after it
+                ReportPin report;
+                {
+                    lock_guard<mutex> guard(systemLock);
+                    streambuf* console = cout.rdbuf(&capture);
+                    if (!system.executeRequest(tokens, tokenCount, connection->sessionToken, &report, &line, starts)) status = "REJECTED";
+                    cout.rdbuf(console);
+                }
+                if (report.guard) report.printAndRelease(reportOut);
+            }
+
+            reply = status;
+            reply += ' ';
+            reply += to_string(output.size());
+            reply += '\n';
+            reply += output;
+            bool delivered = sendAll(connection->fd, reply.data(), reply.size());
+            METRIC_RECORD(OP_SERVER_REQUEST, steadyNanos() - startedAt);
+            served++;
+
+            bool requeue, release;
+            {
+                lock_guard<mutex> guard(connection->lock);
+                if (bye || !delivered) {
+                    // The poll thread sees end-of-stream and drops the connection
+                    connection->finished = true;
+                    connection->pending.clear();
+                    shutdown(connection->fd, SHUT_RDWR);
+                }
+                requeue = !connection->finished && !connection->pending.isEmpty();
+                connection->busy = requeue;
+                release = !requeue && !connection->watched;
+            }
+            if (requeue) ready.push(connection);
+            if (release) delete connection;
+        }
+    }
+
+public:
+    UniverseServer(UniversitySystem& universe) : system(universe), listenFd(-1), served(0), accepted(0),
+        count(0), capacity(64) {
+        fds = new pollfd[capacity];
+        connections = new ServerConnection * [capacity];
+    }
+
+    ~UniverseServer() {
+        for (int i = 1; i < count; i++) delete connections[i];
+        delete[] fds;
+        delete[] connections;
+        if (listenFd >= 0) {
+            close(listenFd);
+            if (address.find_first_not_of("0123456789") != string::npos) unlink(address.c_str());
+        }
+    }
+
+    bool open(const string& where) {
+        address = where;
+        listenFd = openServerSocket(address, true);
+        if (listenFd < 0) return false;
+        watch(listenFd);
+        return true;
+    }
+
+    // Serves until SIGINT or SIGTERM, then lets the workers finish queued requests
+    void run(int workerCount) {
+        thread* workers = new thread[workerCount];
+        for (int i = 0; i < workerCount; i++) {
+            workers[i] = thread(&UniverseServer::serveRequests, this);
+        }
+
+        while (!serverStopRequested) {
+            if (poll(fds, count, 200) <= 0) continue;
+            if (fds[0].revents & POLLIN) acceptConnection();
+            // Backwards, so hangUp's swap with the last slot skips nothing
+            for (int i = count - 1; i >= 1; i--) {
+                if (fds[i].revents && !receive(connections[i])) hangUp(i);
+            }
+        }
+
+        ready.close();
+        for (int i = 0; i < workerCount; i++) workers[i].join();
+        delete[] workers;
+    }
+
+    long long getServed() { return served.load(); }
+    long long getAccepted() { return accepted; }
+};
+
+// Client side of the protocol, with buffered reads
+class ServerClient {
+private:
+    int fd;
+    char buffer[1 << 14];
+    int start, end;
+
+    bool fill() {
+        start = 0;
+        ssize_t received;
+        do {
+            received = recv(fd, buffer, sizeof(buffer), 0);
+        } while (received < 0 && errno == EINTR);
+        end = received > 0 ? (int)received : 0;
+        return end > 0;
+    }
+
+public:
+    ServerClient() : fd(-1), start(0), end(0) {}
+
+    ~ServerClient() {
+        if (fd >= 0) close(fd);
+    }
+
+    bool open(const string& address) {
+        fd = openServerSocket(address, false);
+        return fd >= 0;
+    }
+
+    // Sends one request line and reads its reply; false if the connection broke
+    bool request(const string& line, string& status, string& payload) {
+        string framed = line + '\n';
+        if (!sendAll(fd, framed.data(), framed.size())) return false;
+
+        string header;
+        while (true) {
+            if (start == end && !fill()) return false;
+            char ch = buffer[start++];
+            if (ch == '\n') break;
+            header += ch;
+        }
+        size_t space = header.find(' ');
+        if (space == string::npos) return false;
+        status = header.substr(0, space);
+        size_t length = strtoul(header.c_str() + space + 1, nullptr, 10);
+
+        payload.clear();
+        while (payload.size() < length) {
+            if (start == end && !fill()) return false;
+            size_t take = length - payload.size();
+            if (take > (size_t)(end - start)) take = end - start;
+            payload.append(buffer + start, take);
+            start += (int)take;
+        }
+        return true;
+    }
+};
+
+// Forwards stdin lines to a server and prints each reply
+int runClient(const string& address) {
+    ServerClient client;
+    if (!client.open(address)) {
+        cerr << "Cannot connect to " << address << endl;
+        return 1;
+    }
+    string line, status, payload;
+    while (getline(cin, line)) {
+        if (!client.request(line, status, payload)) {
+            cerr << "Connection closed by server" << endl;
+            return 1;
+        }
+        cout << payload << flush;
+        if (status == "REJECTED") cerr << "(rejected)" << endl;
+        if (status == "BYE") break;
+    }
+    return 0;
+}
+
+// Request mix for load clients, cycled per connection. Every booking is
+// cancelled and every complaint processed, so long runs keep state bounded.
+string loadRequest(int client, long long i) {
+    int day = 1 + (int)((i / 10) % 7);
+    int hour = 8 + client % 10;
+    string slot = " CS10" + to_string(1 + client % 2) + " " + to_string(day) + " "
+        + to_string(hour) + " " + to_string(hour + 1);
+    switch (i % 10) {
+    case 0: return "search-room \"Main Building\" MB101";
+    case 1: return "bfs \"Main Building\"";
+    case 2: return "free-rooms \"CS Block\" " + to_string(day) + " 9 12";
+    case 3: return "book-slots \"CS Block\"" + slot;
+    case 4: return "cancel-slots \"CS Block\"" + slot;
+    case 5: return "complain \"CS Block\" CS101 2 load" + to_string(client) + " issue" + to_string(i);
+    case 6: return "process";
+    case 7: return "send Abeer hello from load" + to_string(client);
+    case 8: return "inbox";
+    default: return "search-user Abeer";
+    }
+}
+
+struct LoadClientResult {
+    long long requests;
+    bool failed;
+    long long slots[LATENCY_SLOTS];
+};
+
+struct LoadStep {
+    const string* address;
+    atomic<int> readyClients;
+    atomic<long long> deadline; // 0 until every client has logged in
+};
+
+void runLoadClient(LoadStep* step, int client, LoadClientResult* result) {
+    result->requests = 0;
+    result->failed = false;
+    for (int s = 0; s < LATENCY_SLOTS; s++) result->slots[s] = 0;
+
+    ServerClient connection;
+    string user = "load" + to_string(client);
+    string status, payload;
+    if (!connection.open(*step->address)
+        || !connection.request("register " + user + " pw student Load " + user + "@nu.edu.pk", status, payload)
+        || !connection.request("login " + user + " pw", status, payload)) {
+        result->failed = true;
+    }
+    step->readyClients++;
+    while (step->deadline.load() == 0) this_thread::sleep_for(chrono::milliseconds(1));
+    if (result->failed) return;
+
+    long long deadline = step->deadline.load();
+    for (long long i = 0; ; i++) {
+        long long sentAt = steadyNanos();
+        if (sentAt >= deadline) break;
+        if (!connection.request(loadRequest(client, i), status, payload)) {
+            result->failed = true;
+            return;
+        }
+        result->slots[latencySlot(steadyNanos() - sentAt)]++;
+        result->requests++;
+    }
+    connection.request("exit", status, payload);
+}
+
+// Runs the request mix at 1, 2, 4, ... maxConnections concurrent connections
+// and reports throughput and latency percentiles for each step
+int runLoadTest(const string& address, int maxConnections, double secondsPerStep) {
+    cout << "Load test against " << address << ", " << secondsPerStep << " s per step" << endl;
+    cout << "conns\trequests\treq/s\tp50 us\tp99 us\tfailed" << endl;
+    long long* slots = new long long[LATENCY_SLOTS];
+
+    for (int connections = 1; ; connections = connections * 2 < maxConnections ? connections * 2 : maxConnections) {
+        LoadStep step;
+        step.address = &address;
+        step.readyClients = 0;
+        step.deadline = 0;
+        LoadClientResult* results = new LoadClientResult[connections];
+        thread* clients = new thread[connections];
+        for (int c = 0; c < connections; c++) {
+            clients[c] = thread(runLoadClient, &step, c, &results[c]);
+        }
+        while (step.readyClients.load() < connections) this_thread::sleep_for(chrono::milliseconds(1));
+        long long startedAt = steadyNanos();
+        step.deadline = startedAt + (long long)(secondsPerStep * 1e9);
+        for (int c = 0; c < connections; c++) clients[c].join();
+        double elapsed = (steadyNanos() - startedAt) / 1e9;
+
+        long long total = 0;
+        int failed = 0;
+        for (int s = 0; s < LATENCY_SLOTS; s++) slots[s] = 0;
+        for (int c = 0; c < connections; c++) {
+            total += results[c].requests;
+            if (results[c].failed) failed++;
+            for (int s = 0; s < LATENCY_SLOTS; s++) slots[s] += results[c].slots[s];
+        }
+        delete[] clients;
+        delete[] results;
+
+        if (failed == connections && total == 0) {
+            cerr << "Cannot reach a server at " << address << endl;
+            delete[] slots;
+            return 1;
+        }
+        char line[160];
+        snprintf(line, sizeof(line), "%d\t%lld\t%.0f\t%.1f\t%.1f\t%d", connections, total, total / elapsed,
+            Metrics::percentile(slots, total, 0.50) / 1e3, Metrics::percentile(slots, total, 0.99) / 1e3, failed);
+        cout << line << endl;
+        if (connections >= maxConnections) break;
+    }
+    delete[] slots;
+    return 0;
+}
+
+#endif
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench-dispatch") {
+        int complaintCount = argc > 2 ? stoi(argv[2]) : 1000000;
+        int producerCount = argc > 3 ? stoi(argv[3]) : 4;
+        benchmarkDispatcher(complaintCount, producerCount);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-message-memory") {
+        int userCount = argc > 2 ? stoi(argv[2]) : 1000;
+        int messageCount = argc > 3 ? stoi(argv[3]) : 1000000;
+        benchmarkMessageMemory(userCount, messageCount);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-intern-memory") {
+        // --bench-intern-memory <seed> <users> <buildings> <rooms per building> <operations>
+        WorkloadConfig config;
+        if (argc > 2) config.seed = stoull(argv[2]);
+        if (argc > 3) config.users = stoi(argv[3]);
+        if (argc > 4) config.buildings = stoi(argv[4]);
+        if (argc > 5) config.roomsPerBuilding = stoi(argv[5]);
+        if (argc > 6) config.operations = stoi(argv[6]);
+        benchmarkInternMemory(config);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-snapshot") {
+        int userCount = argc > 2 ? stoi(argv[2]) : 100000;
+        int roomCount = argc > 3 ? stoi(argv[3]) : 10000;
+        double seconds = argc > 4 ? stod(argv[4]) : 2.0;
+        benchmarkSnapshotReads(userCount, roomCount, seconds);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-export") {
+        int recordCount = argc > 2 ? stoi(argv[2]) : 1000000;
+        string directory = argc > 3 ? argv[3] : ".";
+        benchmarkExport(recordCount, directory);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        int maxSize = argc > 2 ? stoi(argv[2]) : 1000000;
+        string label = argc > 3 ? argv[3] : "uniVerse";
+        runBenchmarks(maxSize, label);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--generate") {
+        // --generate <seed> <users> <buildings> <rooms per building> <operations> [script file]
+        WorkloadConfig config;
+        if (argc > 2) config.seed = stoull(argv[2]);
+        if (argc > 3) config.users = stoi(argv[3]);
+        if (argc > 4) config.buildings = stoi(argv[4]);
+        if (argc > 5) config.roomsPerBuilding = stoi(argv[5]);
+        if (argc > 6) config.operations = stoi(argv[6]);
+
+        if (argc > 7) {
+            ofstream script(argv[7]);
+            if (!script) {
+                cerr << "Cannot open " << argv[7] << endl;
+                return 1;
+            }
+            WorkloadGenerator(config, writeCommandLine, &script).run();
+            return 0;
+        }
+        UniversitySystem sys;
+        sys.beginBatch();
+        WorkloadGenerator(config, UniversitySystem::executeGenerated, &sys).run();
+        sys.endBatch();
+        return 0;
+    }
+    if (argc > 1 && (string(argv[1]) == "--serve" || string(argv[1]) == "--client" || string(argv[1]) == "--load")) {
+#ifndef _WIN32
+        string mode = argv[1];
+        string address = argc > 2 ? argv[2] : "7070";
+        if (mode == "--client") return runClient(address);
+        if (mode == "--load") {
+            int maxConnections = argc > 3 ? stoi(argv[3]) : 64;
+            double secondsPerStep = argc > 4 ? atof(argv[4]) : 2.0;
+            return runLoadTest(address, maxConnections < 1 ? 1 : maxConnections, secondsPerStep);
+        }
+
+        int workerCount = argc > 3 ? stoi(argv[3]) : (int)thread::hardware_concurrency();
+        if (workerCount < 1) workerCount = 4;
+        UniversitySystem sys(argc > 4 ? stoll(argv[4]) : SESSION_IDLE_SECONDS);
+        UniverseServer server(sys);
+        if (!server.open(address)) {
+            cerr << "Cannot listen on " << address << endl;
+            return 1;
+        }
+        signal(SIGINT, requestServerStop);
+        signal(SIGTERM, requestServerStop);
+        cerr << "Serving on " << address << " with " << workerCount << " workers (Ctrl+C to stop)" << endl;
+        server.run(workerCount);
+        cerr << "Server stopped: " << server.getAccepted() << " connections, " << server.getServed() << " requests" << endl;
+        return 0;
+#else
+        cerr << "Server mode needs POSIX sockets" << endl;
+        return 1;
+#endif
+    }
+    if (argc > 1 && string(argv[1]) == "--batch") {
+        UniversitySystem sys;
+        if (argc > 2) {
+            ifstream script(argv[2]);
+            if (!script) {
+                cerr << "Cannot open " << argv[2] << endl;
+                return 1;
+            }
+            sys.runBatch(script);
+        }
+        else {
+            sys.runBatch(cin);
+        }
+        return 0;
+    }
+
     UniversitySystem sys;
     sys.run();
     system("pause");